@@ -0,0 +1,247 @@
+/* mura-headless: the whole of mura on mockswc, for unattended runs on a box
+ * with no seat, GPU or display.
+ *
+ * mura's main() runs as usual, with its wayland socket, mura_stat, mura_top
+ * and the trace ring, but swc is the in-memory mock: one virtual screen of
+ * the given size, a frame clock at the given rate that counts the frames
+ * mura damaged, and input from a replay (-p) or from a socket taking lines
+ * like
+ *
+ *   motion 400 300         move the pointer
+ *   button left 1          press (1) or release (0) left, middle or right
+ *   axis 0 120             wheel, axis 0 vertical and 1 horizontal
+ *   window 0 0 640 480 42  open a window at x y w h, for pid 42
+ *   close 3                close the third window opened
+ *   quit
+ *
+ * clients can connect, but there is no wl_compositor, so only mura's own
+ * protocols work. neuswc has no nested backend, so there is no nested mode.
+ *
+ * usage: mura-headless [-s WxH[@hz]] [-i socket] [mura options]
+ */
+#define main mura_main
+#include "../mura.c"
+#undef main
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "mockswc.h"
+
+struct input_client {
+	int fd;
+	struct wl_event_source *source;
+	char buf[512];
+	size_t len;
+};
+
+static struct {
+	uint32_t width, height, hz;
+	const char *socket_path;
+	int listen_fd;
+	const struct swc_manager *manager;
+	struct wl_event_loop *evloop;
+	struct wl_event_source *frame_timer;
+	uint64_t frames, damaged;
+	struct swc_window **windows;
+	uint32_t nwindows;
+} headless = { .width = 1920, .height = 1080, .hz = 60, .listen_fd = -1 };
+
+static int
+frame_tick(void *data)
+{
+	(void)data;
+	headless.frames++;
+	if (mock_damaged)
+		headless.damaged++;
+	mock_damaged = false;
+	wl_event_source_timer_update(headless.frame_timer, (int)(1000 / headless.hz));
+	return 0;
+}
+
+static uint32_t
+button_code(const char *name)
+{
+	if (strcmp(name, "left") == 0)
+		return BTN_LEFT;
+	if (strcmp(name, "middle") == 0)
+		return BTN_MIDDLE;
+	if (strcmp(name, "right") == 0)
+		return BTN_RIGHT;
+	return (uint32_t)strtoul(name, NULL, 0);
+}
+
+static uint32_t
+input_time(void)
+{
+	return (uint32_t)(now_nsec() / 1000000);
+}
+
+static void
+input_command(char *line)
+{
+	struct swc_window *w, **tmp;
+	char name[16];
+	int32_t x, y, a, b;
+	uint32_t width, height, i;
+	int pid = 0;
+
+	if (sscanf(line, "motion %d %d", &x, &y) == 2) {
+		mock_set_cursor_position(x, y);
+	} else if (sscanf(line, "button %15s %d", name, &a) == 2) {
+		if (!mock_button(input_time(), button_code(name), a ? WL_POINTER_BUTTON_STATE_PRESSED
+		                                                    : WL_POINTER_BUTTON_STATE_RELEASED))
+			fprintf(stderr, "headless: nothing bound to button %s\n", name);
+	} else if (sscanf(line, "axis %d %d", &a, &b) == 2) {
+		mock_axis(input_time(), (uint32_t)a, b);
+	} else if (sscanf(line, "window %d %d %u %u %d", &x, &y, &width, &height, &pid) >= 4) {
+		if (!(tmp = realloc(headless.windows, (headless.nwindows + 1) * sizeof(*tmp))))
+			return;
+		headless.windows = tmp;
+		if (!(w = mock_window_new(x, y, width, height, (pid_t)pid)))
+			return;
+		headless.windows[headless.nwindows++] = w;
+		headless.manager->new_window(w);
+	} else if (sscanf(line, "close %u", &i) == 1) {
+		if (i == 0 || i > headless.nwindows || !headless.windows[i - 1])
+			return;
+		mock_window_destroy(headless.windows[i - 1]);
+		headless.windows[i - 1] = NULL;
+	} else if (strncmp(line, "quit", 4) == 0) {
+		terminate();
+	} else if (line[0]) {
+		fprintf(stderr, "headless: cannot parse \"%s\"\n", line);
+	}
+}
+
+static int
+input_read(int fd, uint32_t mask, void *data)
+{
+	struct input_client *c = data;
+	char *line, *nl;
+	ssize_t n;
+
+	n = read(fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len);
+	if (n <= 0 || (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR))) {
+		wl_event_source_remove(c->source);
+		close(c->fd);
+		free(c);
+		return 0;
+	}
+	c->len += (size_t)n;
+	c->buf[c->len] = '\0';
+
+	line = c->buf;
+	while ((nl = strchr(line, '\n'))) {
+		*nl = '\0';
+		input_command(line);
+		line = nl + 1;
+	}
+	c->len -= (size_t)(line - c->buf);
+	memmove(c->buf, line, c->len);
+	/* a line longer than the buffer is dropped */
+	if (c->len == sizeof(c->buf) - 1)
+		c->len = 0;
+	return 0;
+}
+
+static int
+input_accept(int fd, uint32_t mask, void *data)
+{
+	struct input_client *c;
+	int client;
+
+	(void)mask;
+	(void)data;
+	if ((client = accept(fd, NULL, NULL)) < 0)
+		return 0;
+	if (!(c = calloc(1, sizeof(*c)))) {
+		close(client);
+		return 0;
+	}
+	c->fd = client;
+	c->source = wl_event_loop_add_fd(headless.evloop, client, WL_EVENT_READABLE, input_read, c);
+	if (!c->source) {
+		close(client);
+		free(c);
+	}
+	return 0;
+}
+
+static bool
+input_listen(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+		return false;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	headless.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (headless.listen_fd < 0)
+		return false;
+	if (bind(headless.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(headless.listen_fd, 4) < 0) {
+		close(headless.listen_fd);
+		headless.listen_fd = -1;
+		return false;
+	}
+	return wl_event_loop_add_fd(headless.evloop, headless.listen_fd, WL_EVENT_READABLE,
+	                            input_accept, NULL) != NULL;
+}
+
+/* swc would find the outputs and the seat here */
+static void
+headless_initialize(struct wl_display *display, struct wl_event_loop *event_loop,
+                    const struct swc_manager *manager)
+{
+	(void)display;
+	headless.manager = manager;
+	headless.evloop = event_loop;
+
+	manager->new_screen(mock_screen_new(0, 0, headless.width, headless.height));
+
+	headless.frame_timer = wl_event_loop_add_timer(event_loop, frame_tick, NULL);
+	if (headless.frame_timer)
+		wl_event_source_timer_update(headless.frame_timer, (int)(1000 / headless.hz));
+
+	if (headless.socket_path && !input_listen(headless.socket_path))
+		fprintf(stderr, "headless: cannot listen on %s\n", headless.socket_path);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char **args;
+	int nargs = 1, ret;
+
+	/* take -s and -i, hand the rest to mura */
+	if (!(args = calloc((size_t)argc + 1, sizeof(*args))))
+		return 1;
+	args[0] = argv[0];
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			i++;
+			if (sscanf(argv[i], "%ux%u@%u", &headless.width, &headless.height, &headless.hz) < 2 ||
+			    headless.width == 0 || headless.height == 0 || headless.hz == 0 || headless.hz > 1000) {
+				fprintf(stderr, "headless: -s wants WxH or WxH@hz\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			headless.socket_path = argv[++i];
+		} else {
+			args[nargs++] = argv[i];
+		}
+	}
+
+	mock_initialize = headless_initialize;
+	ret = mura_main(nargs, args);
+
+	fprintf(stderr, "headless: %" PRIu64 " frames at %u Hz, %" PRIu64 " damaged\n",
+	        headless.frames, headless.hz, headless.damaged);
+	if (headless.socket_path && headless.listen_fd >= 0)
+		unlink(headless.socket_path);
+	free(headless.windows);
+	free(args);
+	return ret;
+}
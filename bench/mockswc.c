@@ -0,0 +1,463 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mockswc.h"
+
+struct mock_window {
+	struct swc_window base;
+	struct swc_rectangle geometry;
+	bool shown;
+	pid_t pid;
+	const struct swc_window_handler *handler;
+	void *data;
+	struct mock_window *above, *below;
+};
+
+struct mock_screen {
+	struct swc_screen base;
+	const struct swc_screen_handler *handler;
+	void *data;
+};
+
+#define MOCK_BINDINGS 16
+
+struct mock_binding {
+	uint32_t value;
+	swc_binding_handler handler;
+	swc_axis_binding_handler axis_handler;
+	void *data;
+};
+
+uint64_t mock_calls[MOCK_CALL_COUNT];
+bool mock_damaged;
+void (*mock_initialize)(struct wl_display *display, struct wl_event_loop *event_loop,
+                        const struct swc_manager *manager);
+
+const char *const mock_call_names[MOCK_CALL_COUNT] = {
+	[MOCK_GET_GEOMETRY] = "get_geometry",
+	[MOCK_SET_POSITION] = "set_position",
+	[MOCK_SET_GEOMETRY] = "set_geometry",
+	[MOCK_WINDOW_AT]    = "window_at",
+	[MOCK_FOCUS]        = "focus",
+	[MOCK_SET_BORDER]   = "set_border",
+	[MOCK_SHOW_HIDE]    = "show_hide",
+	[MOCK_ZOOM]         = "zoom",
+	[MOCK_CURSOR]       = "cursor",
+	[MOCK_OVERLAY]      = "overlay",
+	[MOCK_POINTER_SEND] = "pointer_send",
+	[MOCK_OTHER]        = "other",
+};
+
+/* newest window on top */
+static struct mock_window *top;
+static int32_t cursor_x, cursor_y;
+static float zoom = 1.0f;
+static struct mock_binding buttons[MOCK_BINDINGS], axes[MOCK_BINDINGS];
+static int nbuttons, naxes;
+
+#define MOCK(w) ((struct mock_window *)(w))
+
+struct swc_window *
+mock_window_new(int32_t x, int32_t y, uint32_t width, uint32_t height, pid_t pid)
+{
+	struct mock_window *w = calloc(1, sizeof(*w));
+
+	if (!w)
+		return NULL;
+	w->geometry = (struct swc_rectangle){ x, y, width, height };
+	w->pid = pid;
+	w->below = top;
+	if (top)
+		top->above = w;
+	top = w;
+	return &w->base;
+}
+
+void
+mock_window_destroy(struct swc_window *window)
+{
+	struct mock_window *w = MOCK(window);
+
+	if (w->handler && w->handler->destroy)
+		w->handler->destroy(w->data);
+	if (w->above)
+		w->above->below = w->below;
+	else
+		top = w->below;
+	if (w->below)
+		w->below->above = w->above;
+	free(w);
+}
+
+struct swc_screen *
+mock_screen_new(int32_t x, int32_t y, uint32_t width, uint32_t height)
+{
+	struct mock_screen *s = calloc(1, sizeof(*s));
+
+	if (!s)
+		return NULL;
+	s->base.geometry = (struct swc_rectangle){ x, y, width, height };
+	s->base.usable_geometry = s->base.geometry;
+	return &s->base;
+}
+
+void
+mock_screen_destroy(struct swc_screen *screen)
+{
+	struct mock_screen *s = (struct mock_screen *)screen;
+
+	if (s->handler && s->handler->destroy)
+		s->handler->destroy(s->data);
+	free(s);
+}
+
+void
+mock_set_cursor_position(int32_t x, int32_t y)
+{
+	cursor_x = x;
+	cursor_y = y;
+}
+
+bool
+mock_button(uint32_t time, uint32_t button, uint32_t state)
+{
+	for (int i = 0; i < nbuttons; i++) {
+		if (buttons[i].value == button) {
+			buttons[i].handler(buttons[i].data, time, button, state);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+mock_axis(uint32_t time, uint32_t axis, int32_t value120)
+{
+	for (int i = 0; i < naxes; i++) {
+		if (axes[i].value == axis) {
+			axes[i].axis_handler(axes[i].data, time, axis, value120);
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t
+mock_calls_total(void)
+{
+	uint64_t n = 0;
+
+	for (int i = 0; i < MOCK_CALL_COUNT; i++)
+		n += mock_calls[i];
+	return n;
+}
+
+void
+mock_calls_reset(void)
+{
+	memset(mock_calls, 0, sizeof(mock_calls));
+}
+
+/* the swc.h subset mura links against */
+
+void
+swc_screen_set_handler(struct swc_screen *screen, const struct swc_screen_handler *handler, void *data)
+{
+	struct mock_screen *s = (struct mock_screen *)screen;
+
+	mock_calls[MOCK_OTHER]++;
+	s->handler = handler;
+	s->data = data;
+}
+
+void
+swc_window_set_handler(struct swc_window *window, const struct swc_window_handler *handler, void *data)
+{
+	mock_calls[MOCK_OTHER]++;
+	MOCK(window)->handler = handler;
+	MOCK(window)->data = data;
+}
+
+void
+swc_window_close(struct swc_window *window)
+{
+	(void)window;
+	mock_calls[MOCK_OTHER]++;
+}
+
+void
+swc_window_show(struct swc_window *window)
+{
+	mock_calls[MOCK_SHOW_HIDE]++;
+	mock_damaged = true;
+	MOCK(window)->shown = true;
+}
+
+void
+swc_window_hide(struct swc_window *window)
+{
+	mock_calls[MOCK_SHOW_HIDE]++;
+	mock_damaged = true;
+	MOCK(window)->shown = false;
+}
+
+void
+swc_window_focus(struct swc_window *window)
+{
+	(void)window;
+	mock_calls[MOCK_FOCUS]++;
+}
+
+void
+swc_window_set_stacked(struct swc_window *window)
+{
+	(void)window;
+	mock_calls[MOCK_OTHER]++;
+}
+
+void
+swc_window_set_tiled(struct swc_window *window)
+{
+	(void)window;
+	mock_calls[MOCK_OTHER]++;
+}
+
+void
+swc_window_set_fullscreen(struct swc_window *window, struct swc_screen *screen)
+{
+	mock_calls[MOCK_SET_GEOMETRY]++;
+	mock_damaged = true;
+	MOCK(window)->geometry = screen->geometry;
+}
+
+void
+swc_window_set_position(struct swc_window *window, int32_t x, int32_t y)
+{
+	mock_calls[MOCK_SET_POSITION]++;
+	mock_damaged = true;
+	MOCK(window)->geometry.x = x;
+	MOCK(window)->geometry.y = y;
+}
+
+void
+swc_window_set_size(struct swc_window *window, uint32_t width, uint32_t height)
+{
+	mock_calls[MOCK_SET_GEOMETRY]++;
+	mock_damaged = true;
+	MOCK(window)->geometry.width = width;
+	MOCK(window)->geometry.height = height;
+}
+
+void
+swc_window_set_geometry(struct swc_window *window, const struct swc_rectangle *geometry)
+{
+	mock_calls[MOCK_SET_GEOMETRY]++;
+	mock_damaged = true;
+	MOCK(window)->geometry = *geometry;
+}
+
+bool
+swc_window_get_geometry(struct swc_window *window, struct swc_rectangle *geometry)
+{
+	mock_calls[MOCK_GET_GEOMETRY]++;
+	*geometry = MOCK(window)->geometry;
+	return true;
+}
+
+void
+swc_window_set_border(struct swc_window *window, uint32_t inner_color, uint32_t inner_width,
+                      uint32_t outer_color, uint32_t outer_width)
+{
+	(void)window;
+	(void)inner_color;
+	(void)inner_width;
+	(void)outer_color;
+	(void)outer_width;
+	mock_calls[MOCK_SET_BORDER]++;
+	mock_damaged = true;
+}
+
+void
+swc_window_begin_move(struct swc_window *window)
+{
+	(void)window;
+	mock_calls[MOCK_OTHER]++;
+}
+
+void
+swc_window_end_move(struct swc_window *window)
+{
+	(void)window;
+	mock_calls[MOCK_OTHER]++;
+}
+
+void
+swc_window_begin_resize(struct swc_window *window, uint32_t edges)
+{
+	(void)window;
+	(void)edges;
+	mock_calls[MOCK_OTHER]++;
+}
+
+void
+swc_window_end_resize(struct swc_window *window)
+{
+	(void)window;
+	mock_calls[MOCK_OTHER]++;
+}
+
+pid_t
+swc_window_get_pid(struct swc_window *window)
+{
+	mock_calls[MOCK_OTHER]++;
+	return MOCK(window)->pid;
+}
+
+struct swc_window *
+swc_window_at(int32_t x, int32_t y)
+{
+	struct mock_window *w;
+
+	mock_calls[MOCK_WINDOW_AT]++;
+	for (w = top; w; w = w->below) {
+		struct swc_rectangle *g = &w->geometry;
+
+		if (w->shown && x >= g->x && y >= g->y &&
+		    x < g->x + (int32_t)g->width && y < g->y + (int32_t)g->height)
+			return &w->base;
+	}
+	return NULL;
+}
+
+float
+swc_get_zoom(void)
+{
+	mock_calls[MOCK_ZOOM]++;
+	return zoom;
+}
+
+void
+swc_set_zoom(float z)
+{
+	mock_calls[MOCK_ZOOM]++;
+	mock_damaged = true;
+	zoom = z;
+}
+
+bool
+swc_cursor_position(wl_fixed_t *x, wl_fixed_t *y)
+{
+	mock_calls[MOCK_CURSOR]++;
+	*x = wl_fixed_from_int(cursor_x);
+	*y = wl_fixed_from_int(cursor_y);
+	return true;
+}
+
+void
+swc_set_cursor(int cursor)
+{
+	(void)cursor;
+	mock_calls[MOCK_CURSOR]++;
+}
+
+void
+swc_set_cursor_mode(int mode)
+{
+	(void)mode;
+	mock_calls[MOCK_CURSOR]++;
+}
+
+void
+swc_set_cursor_image(int cursor, const uint32_t *data, uint32_t w, uint32_t h, int32_t hx, int32_t hy)
+{
+	(void)cursor;
+	(void)data;
+	(void)w;
+	(void)h;
+	(void)hx;
+	(void)hy;
+	mock_calls[MOCK_CURSOR]++;
+	mock_damaged = true;
+}
+
+void
+swc_overlay_set_box(int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color, uint32_t border)
+{
+	(void)x1;
+	(void)y1;
+	(void)x2;
+	(void)y2;
+	(void)color;
+	(void)border;
+	mock_calls[MOCK_OVERLAY]++;
+	mock_damaged = true;
+}
+
+void
+swc_overlay_clear(void)
+{
+	mock_calls[MOCK_OVERLAY]++;
+	mock_damaged = true;
+}
+
+void
+swc_pointer_send_button(uint32_t time, uint32_t button, uint32_t state)
+{
+	(void)time;
+	(void)button;
+	(void)state;
+	mock_calls[MOCK_POINTER_SEND]++;
+}
+
+void
+swc_pointer_send_axis(uint32_t time, uint32_t axis, int32_t value120)
+{
+	(void)time;
+	(void)axis;
+	(void)value120;
+	mock_calls[MOCK_POINTER_SEND]++;
+}
+
+/* modifiers are ignored, mura binds its buttons with SWC_MOD_ANY */
+int
+swc_add_binding(enum swc_binding_type type, uint32_t modifiers, uint32_t value,
+                swc_binding_handler handler, void *data)
+{
+	(void)modifiers;
+	mock_calls[MOCK_OTHER]++;
+	if (type != SWC_BINDING_BUTTON)
+		return 0;
+	if (nbuttons == MOCK_BINDINGS)
+		return -1;
+	buttons[nbuttons++] = (struct mock_binding){ value, handler, NULL, data };
+	return 0;
+}
+
+int
+swc_add_axis_binding(uint32_t modifiers, uint32_t axis, swc_axis_binding_handler handler, void *data)
+{
+	(void)modifiers;
+	mock_calls[MOCK_OTHER]++;
+	if (naxes == MOCK_BINDINGS)
+		return -1;
+	axes[naxes++] = (struct mock_binding){ axis, NULL, handler, data };
+	return 0;
+}
+
+bool
+swc_initialize(struct wl_display *display, struct wl_event_loop *event_loop, const struct swc_manager *manager)
+{
+	mock_calls[MOCK_OTHER]++;
+	if (mock_initialize)
+		mock_initialize(display, event_loop, manager);
+	return true;
+}
+
+void
+swc_finalize(void)
+{
+	mock_calls[MOCK_OTHER]++;
+}
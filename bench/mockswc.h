@@ -0,0 +1,61 @@
+/* mockswc: an in-memory stand-in for the part of libswc mura uses, so
+ * mura's logic can run without a seat, a DRM device or a display.
+ *
+ * windows and screens are plain structs, geometry is whatever was last set,
+ * swc_window_at() walks the shown windows top-down, and every call is
+ * counted so benchmarks can report how much swc work an operation causes.
+ * bindings are kept, so input can be fed to them like swc's seat would.
+ */
+#ifndef MOCKSWC_H
+#define MOCKSWC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <swc.h>
+
+enum mock_call {
+	MOCK_GET_GEOMETRY,
+	MOCK_SET_POSITION,
+	MOCK_SET_GEOMETRY,
+	MOCK_WINDOW_AT,
+	MOCK_FOCUS,
+	MOCK_SET_BORDER,
+	MOCK_SHOW_HIDE,
+	MOCK_ZOOM,
+	MOCK_CURSOR,
+	MOCK_OVERLAY,
+	MOCK_POINTER_SEND,
+	MOCK_OTHER,
+	MOCK_CALL_COUNT,
+};
+
+extern uint64_t mock_calls[MOCK_CALL_COUNT];
+extern const char *const mock_call_names[MOCK_CALL_COUNT];
+
+/* set by anything that would make swc repaint: moving, resizing, showing,
+ * hiding, borders, zoom, the cursor and the overlay */
+extern bool mock_damaged;
+
+/* called from swc_initialize(), which is where swc finds its outputs */
+extern void (*mock_initialize)(struct wl_display *display, struct wl_event_loop *event_loop,
+                               const struct swc_manager *manager);
+
+struct swc_window *mock_window_new(int32_t x, int32_t y, uint32_t width, uint32_t height, pid_t pid);
+
+/* runs the window's destroy handler, like a client going away */
+void mock_window_destroy(struct swc_window *window);
+
+struct swc_screen *mock_screen_new(int32_t x, int32_t y, uint32_t width, uint32_t height);
+void mock_screen_destroy(struct swc_screen *screen);
+
+void mock_set_cursor_position(int32_t x, int32_t y);
+
+/* run the binding for a button or axis, false when nothing is bound */
+bool mock_button(uint32_t time, uint32_t button, uint32_t state);
+bool mock_axis(uint32_t time, uint32_t axis, int32_t value120);
+
+uint64_t mock_calls_total(void);
+void mock_calls_reset(void);
+
+#endif
@@ -0,0 +1,367 @@
+/* murabench: time mura's own logic against mockswc at 10, 1k and 10k windows.
+ *
+ * mura.c is built into this file with its main() renamed, so the benchmarks
+ * call the same static handlers a real session does. swc is the in-memory
+ * mock, so what is measured is mura's work plus the cheapest possible swc.
+ *
+ * usage: murabench [-o file] [-c file] [windows ...]
+ *        murabench [-w | -p trace] [windows]
+ *   -o file   save the results, to compare a later run against
+ *   -c file   show how ns/op moved since a saved run
+ *   -w        replay a made-up session of clicks, scrolls, jumps and spawns
+ *             through mura's own event loop instead, as a training run
+ *   -p trace  the same with an input trace recorded by mura -r
+ */
+#define main mura_main
+#include "../mura.c"
+#undef main
+
+#include "mockswc.h"
+
+#define BENCH_NS 50000000 /* run each op for at least this long */
+
+static struct swc_window **bench_windows;
+static uint32_t bench_nwindows;
+static uint32_t bench_seed = 1;
+
+static uint32_t
+bench_rand(void)
+{
+	bench_seed = bench_seed * 1664525u + 1013904223u;
+	return bench_seed >> 8;
+}
+
+static void
+bench_init(void)
+{
+	struct swc_screen *screen;
+
+	mura.spawner.fd = -1;
+	wl_list_init(&mura.windows);
+	wl_list_init(&mura.screens);
+	wl_list_init(&mura.gesture.devices);
+	wl_list_init(&mura.spawns);
+	for (int i = 0; i < PID_BUCKETS; i++) {
+		wl_list_init(&mura.window_pids[i]);
+		wl_list_init(&mura.procs[i]);
+	}
+	wl_list_init(&mura.tele.surfaces);
+	wl_list_init(&mura.camera.clients);
+	wl_list_init(&mura.wlist.clients);
+	wl_list_init(&mura.wlist.dirty);
+	wl_list_init(&mura.control.clients);
+
+	mura.display = wl_display_create();
+	if (!mura.display) {
+		fprintf(stderr, "cannot create display\n");
+		exit(1);
+	}
+	mura.evloop = wl_display_get_event_loop(mura.display);
+
+	screen = mock_screen_new(0, 0, 1920, 1080);
+	newscreen(screen);
+	mura.current_screen = wl_container_of(mura.screens.next, mura.current_screen, link);
+	mock_set_cursor_position(960, 540);
+}
+
+/* spread windows over a plane a few screens tall, so some are on screen
+ * and most are not, like a long session */
+static void
+bench_populate(uint32_t n)
+{
+	uint32_t i;
+
+	bench_windows = calloc(n, sizeof(*bench_windows));
+	if (!bench_windows)
+		exit(1);
+	for (i = 0; i < n; i++) {
+		int32_t x = (int32_t)(bench_rand() % 3840) - 960;
+		int32_t y = (int32_t)(bench_rand() % (1080 * (n / 10 + 1))) - 540;
+
+		bench_windows[i] = mock_window_new(x, y, 400 + bench_rand() % 400, 300 + bench_rand() % 300,
+		                                   (pid_t)(10000 + i));
+		newwindow(bench_windows[i]);
+	}
+	bench_nwindows = n;
+	scroll_stop();
+}
+
+static void
+bench_depopulate(void)
+{
+	for (uint32_t i = 0; i < bench_nwindows; i++)
+		mock_window_destroy(bench_windows[i]);
+	free(bench_windows);
+	bench_windows = NULL;
+	bench_nwindows = 0;
+	scroll_stop();
+}
+
+/* one scroll timer tick mid-scroll, every window is looked at */
+static void
+op_pan_tick(uint32_t i)
+{
+	(void)i;
+	if (!mura.chord.scroll_timer)
+		mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+	mura.chord.auto_scrolling = true;
+	mura.chord.scroll_pending_px = (i & 1) ? 64 : -64;
+	scroll_tick(NULL);
+}
+
+/* a left click somewhere on screen: hit test, focus, forward */
+static void
+op_click(uint32_t i)
+{
+	mock_set_cursor_position((int32_t)(bench_rand() % 1920), (int32_t)(bench_rand() % 1080));
+	button(NULL, i, BTN_LEFT, WL_POINTER_BUTTON_STATE_PRESSED);
+	button(NULL, i, BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED);
+	click_cancel();
+}
+
+/* the 2-1 chord, which jumps to the closest window under JUMP */
+static void
+op_chord_21(uint32_t i)
+{
+	mock_set_cursor_position((int32_t)(bench_rand() % 1920), (int32_t)(bench_rand() % 1080));
+	button(NULL, i, BTN_LEFT, WL_POINTER_BUTTON_STATE_PRESSED);
+	button(NULL, i, BTN_MIDDLE, WL_POINTER_BUTTON_STATE_PRESSED);
+	button(NULL, i, BTN_MIDDLE, WL_POINTER_BUTTON_STATE_RELEASED);
+	button(NULL, i, BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED);
+	click_cancel();
+	scroll_stop();
+}
+
+static void
+op_focus(uint32_t i)
+{
+	focus_window(bench_windows[i % bench_nwindows], "bench");
+	scroll_stop();
+}
+
+/* a window appearing and going away again */
+static void
+op_spawn(uint32_t i)
+{
+	struct swc_window *swc = mock_window_new((int32_t)(bench_rand() % 1920), (int32_t)(bench_rand() % 1080),
+	                                         640, 480, (pid_t)(1000000 + i));
+
+	newwindow(swc);
+	mock_window_destroy(swc);
+	scroll_stop();
+}
+
+static const struct {
+	const char *name;
+	void (*run)(uint32_t i);
+} ops[] = {
+	{ "pan_tick", op_pan_tick },
+	{ "click", op_click },
+	{ "chord_2_1", op_chord_21 },
+	{ "focus", op_focus },
+	{ "spawn", op_spawn },
+};
+
+struct result {
+	char op[16];
+	uint32_t windows;
+	double ns;
+};
+
+static struct result *saved;
+static size_t nsaved;
+
+static void
+bench_op(int op, uint32_t n, FILE *out)
+{
+	uint64_t start, elapsed, calls;
+	uint32_t iters = 0, batch = 1, i;
+	double ns;
+
+	mock_calls_reset();
+	start = now_nsec();
+	do {
+		for (i = 0; i < batch; i++)
+			ops[op].run(iters + i);
+		iters += batch;
+		batch *= 2;
+		elapsed = now_nsec() - start;
+	} while (elapsed < BENCH_NS);
+	calls = mock_calls_total();
+	ns = (double)elapsed / iters;
+
+	printf("%-10s %8u %12.1f %12.1f %12.1f", ops[op].name, n, ns, (double)calls / iters,
+	       (double)mock_calls[MOCK_GET_GEOMETRY] / iters);
+	for (size_t j = 0; j < nsaved; j++) {
+		if (saved[j].windows == n && strcmp(saved[j].op, ops[op].name) == 0) {
+			printf(" %+7.1f%%", (ns - saved[j].ns) * 100.0 / saved[j].ns);
+			break;
+		}
+	}
+	printf("\n");
+	if (out)
+		fprintf(out, "%s %u %.1f\n", ops[op].name, n, ns);
+}
+
+static void
+load_results(const char *path)
+{
+	struct result r, *tmp;
+	FILE *f;
+
+	if (!(f = fopen(path, "r"))) {
+		fprintf(stderr, "cannot open %s\n", path);
+		exit(1);
+	}
+	while (fscanf(f, "%15s %u %lf", r.op, &r.windows, &r.ns) == 3) {
+		if (!(tmp = realloc(saved, (nsaved + 1) * sizeof(*saved))))
+			exit(1);
+		saved = tmp;
+		saved[nsaved++] = r;
+	}
+	fclose(f);
+}
+
+static void
+workload_add(uint32_t msec, uint16_t type, uint16_t code, int32_t a, int32_t b)
+{
+	static size_t cap;
+	struct input_event *events;
+
+	if (mura.input.nevents == cap) {
+		cap = cap ? cap * 2 : 1024;
+		if (!(events = realloc(mura.input.events, cap * sizeof(*events))))
+			exit(1);
+		mura.input.events = events;
+	}
+	mura.input.events[mura.input.nevents++] = (struct input_event){ msec, type, code, a, b };
+}
+
+/* a made-up session in the shape of a real one: every round clicks a
+ * window, drag-scrolls the plane (3-2, then drag with 3 held), jumps with
+ * the 1-2 chord, and every few rounds sweeps out a terminal (1-3) */
+static void
+workload_generate(void)
+{
+	uint32_t t = 0;
+	int32_t x, y;
+
+	for (int round = 0; round < 60; round++) {
+		x = (int32_t)(bench_rand() % 1920);
+		y = (int32_t)(bench_rand() % 1080);
+		workload_add(t += 30, INPUT_MOTION, 0, x, y);
+		workload_add(t += 40, INPUT_BUTTON, BTN_LEFT, WL_POINTER_BUTTON_STATE_PRESSED, 0);
+		workload_add(t += 60, INPUT_BUTTON, BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED, 0);
+
+		workload_add(t += 200, INPUT_BUTTON, BTN_RIGHT, WL_POINTER_BUTTON_STATE_PRESSED, 0);
+		workload_add(t += 30, INPUT_BUTTON, BTN_MIDDLE, WL_POINTER_BUTTON_STATE_PRESSED, 0);
+		workload_add(t += 30, INPUT_BUTTON, BTN_MIDDLE, WL_POINTER_BUTTON_STATE_RELEASED, 0);
+		for (int i = 0; i < 30; i++)
+			workload_add(t += 8, INPUT_MOTION, 0, x + i * 12 * (round & 1 ? 1 : -1), y + i * 20);
+		workload_add(t += 30, INPUT_BUTTON, BTN_RIGHT, WL_POINTER_BUTTON_STATE_RELEASED, 0);
+		if (round % 4 == 0)
+			workload_add(t += 16, INPUT_AXIS, 0, 120 * (round & 2 ? 1 : -1), 0);
+
+		workload_add(t += 300, INPUT_BUTTON, BTN_LEFT, WL_POINTER_BUTTON_STATE_PRESSED, 0);
+		workload_add(t += 30, INPUT_BUTTON, BTN_MIDDLE, WL_POINTER_BUTTON_STATE_PRESSED, 0);
+		workload_add(t += 30, INPUT_BUTTON, BTN_MIDDLE, WL_POINTER_BUTTON_STATE_RELEASED, 0);
+		workload_add(t += 30, INPUT_BUTTON, BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED, 0);
+
+		if (round % 5 == 0) {
+			workload_add(t += 300, INPUT_BUTTON, BTN_LEFT, WL_POINTER_BUTTON_STATE_PRESSED, 0);
+			workload_add(t += 30, INPUT_BUTTON, BTN_RIGHT, WL_POINTER_BUTTON_STATE_PRESSED, 0);
+			for (int i = 0; i < 10; i++)
+				workload_add(t += 8, INPUT_MOTION, 0, x + i * 30, y + i * 20);
+			workload_add(t += 30, INPUT_BUTTON, BTN_RIGHT, WL_POINTER_BUTTON_STATE_RELEASED, 0);
+			workload_add(t += 30, INPUT_BUTTON, BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED, 0);
+		}
+	}
+}
+
+/* the replay ends by stopping run(), like it does in a real session */
+static void
+bench_replay(const char *path, uint32_t n)
+{
+	if (path) {
+		if (!replay_load(path))
+			exit(1);
+	} else {
+		workload_generate();
+	}
+	/* spawns go all the way to the helper, but no terminal may start */
+	setenv("PATH", "/var/empty", 1);
+	mura.input.fast = true;
+	bench_populate(n);
+	if (!replay_start())
+		exit(1);
+	run();
+	bench_depopulate();
+}
+
+static void
+bench_usage(void)
+{
+	fprintf(stderr, "usage: murabench [-o file] [-c file] [windows ...]\n"
+	                "       murabench [-w | -p trace] [windows]\n");
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const uint32_t sizes[] = { 10, 1000, 10000 };
+	const char *trace = NULL;
+	bool replay = false;
+	FILE *out = NULL;
+	uint32_t n;
+	int c, i, nsizes;
+
+	while ((c = getopt(argc, argv, "o:c:wp:")) != -1) {
+		switch (c) {
+		case 'o':
+			if (!(out = fopen(optarg, "w"))) {
+				fprintf(stderr, "cannot write %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'c':
+			load_results(optarg);
+			break;
+		case 'w':
+			replay = true;
+			break;
+		case 'p':
+			replay = true;
+			trace = optarg;
+			break;
+		default:
+			bench_usage();
+		}
+	}
+	argv += optind;
+	nsizes = argc - optind;
+
+	bench_init();
+
+	if (replay) {
+		if (nsizes > 1)
+			bench_usage();
+		bench_replay(trace, nsizes ? (uint32_t)strtoul(argv[0], NULL, 10) : 1000);
+		return 0;
+	}
+
+	printf("%-10s %8s %12s %12s %12s%s\n", "op", "windows", "ns/op", "swc calls", "geometry",
+	       nsaved ? "   change" : "");
+	for (i = 0; i < (nsizes ? nsizes : 3); i++) {
+		n = nsizes ? (uint32_t)strtoul(argv[i], NULL, 10) : sizes[i];
+		if (n == 0)
+			continue;
+		bench_populate(n);
+		for (size_t op = 0; op < sizeof(ops) / sizeof(ops[0]); op++)
+			bench_op((int)op, n, out);
+		bench_depopulate();
+	}
+	if (out)
+		fclose(out);
+	return 0;
+}
@@ -0,0 +1,119 @@
+/* spawnbench: what starting a child costs the process that asks for it.
+ *
+ * For each size, the benchmark grows its own heap to that many MiB (touching
+ * every page, like a compositor with mapped buffers) and then times, from the
+ * parent's side, fork()+exec as mura used to do it against a request to the
+ * spawn helper that was forked before the heap grew.
+ *
+ * usage: spawnbench [MiB ...]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../spawner.h"
+
+#define ROUNDS 32
+
+static uint64_t
+now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t
+bench_fork(void)
+{
+	uint64_t start, total = 0;
+	pid_t pid;
+	int i;
+
+	for (i = 0; i < ROUNDS; i++) {
+		start = now_nsec();
+		pid = fork();
+		if (pid == 0) {
+			execlp("true", "true", (char *)NULL);
+			_exit(127);
+		}
+		total += now_nsec() - start;
+		waitpid(pid, NULL, 0);
+	}
+	return total / ROUNDS;
+}
+
+static uint64_t
+bench_helper(int fd)
+{
+	char *argv[] = { "true", NULL };
+	struct spawn_event ev;
+	struct pollfd pfd = { fd, POLLIN, 0 };
+	uint64_t start, total = 0;
+	int i, exited;
+
+	for (i = 0; i < ROUNDS; i++) {
+		start = now_nsec();
+		if (!spawn_request(fd, (uint32_t)i + 1, argv, NULL)) {
+			fprintf(stderr, "spawn request failed\n");
+			exit(1);
+		}
+		total += now_nsec() - start;
+
+		/* wait for the child to be gone before the next round */
+		for (exited = 0; !exited && poll(&pfd, 1, 1000) > 0;) {
+			while (spawn_read_event(fd, &ev)) {
+				if (ev.type != SPAWN_STARTED)
+					exited = 1;
+			}
+		}
+	}
+	return total / ROUNDS;
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const size_t sizes[] = { 0, 64, 256, 1024 };
+	size_t i, n = argc > 1 ? (size_t)argc - 1 : sizeof(sizes) / sizeof(sizes[0]);
+	char *heap = NULL;
+	int fd;
+
+	fd = spawn_helper_start();
+	if (fd < 0) {
+		fprintf(stderr, "cannot start spawn helper\n");
+		return 1;
+	}
+
+	printf("%8s %12s %12s\n", "MiB", "fork ns", "helper ns");
+	for (i = 0; i < n; i++) {
+		size_t mib = argc > 1 ? strtoul(argv[i + 1], NULL, 10) : sizes[i];
+
+		free(heap);
+		heap = NULL;
+		if (mib) {
+			heap = malloc(mib << 20);
+			if (!heap) {
+				fprintf(stderr, "cannot allocate %zu MiB\n", mib);
+				return 1;
+			}
+			memset(heap, 1, mib << 20);
+		}
+
+		printf("%8zu %12llu %12llu\n", mib,
+		       (unsigned long long)bench_fork(), (unsigned long long)bench_helper(fd));
+		fflush(stdout);
+	}
+
+	free(heap);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,62 @@
+/* camera: the plane's position, zoom and focused window in a shared page,
+ * handed out by mura_scroll.get_page and read with no messages at all.
+ *
+ * mura is the only writer. it makes seq odd, writes the fields and makes seq
+ * even again, once a frame at most and only when something changed. a
+ * reader copies the fields between two loads of seq and keeps the copy when
+ * both loads are the same even number.
+ */
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CAMERA_MAGIC 0x4d41434d /* "MCAM" */
+#define CAMERA_VERSION 1
+
+struct camera_page {
+	uint32_t magic, version;
+	uint32_t seq;   /* odd while mura writes */
+	uint32_t focus; /* mura_top id of the focused window, 0 for none */
+	int64_t x, y;   /* what mura_scroll.position carries */
+	uint32_t zoom;  /* 16.16 fixed point, 65536 for no zoom */
+	uint32_t pad;
+	uint64_t updates;
+	uint64_t time;  /* CLOCK_MONOTONIC ns of the last update */
+};
+
+/* the fields are loaded one at a time so a torn copy is only ever thrown
+ * away, never acted on. false when mura kept the page busy for all the tries
+ * or the page is not one this reader knows */
+static inline bool
+camera_read(const struct camera_page *page, struct camera_page *out)
+{
+	uint32_t seq;
+
+	if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != CAMERA_MAGIC ||
+	    page->version != CAMERA_VERSION)
+		return false;
+	for (int i = 0; i < 1000; i++) {
+		seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+		out->focus = __atomic_load_n(&page->focus, __ATOMIC_RELAXED);
+		out->x = __atomic_load_n(&page->x, __ATOMIC_RELAXED);
+		out->y = __atomic_load_n(&page->y, __ATOMIC_RELAXED);
+		out->zoom = __atomic_load_n(&page->zoom, __ATOMIC_RELAXED);
+		out->updates = __atomic_load_n(&page->updates, __ATOMIC_RELAXED);
+		out->time = __atomic_load_n(&page->time, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == seq) {
+			out->magic = CAMERA_MAGIC;
+			out->version = CAMERA_VERSION;
+			out->seq = seq;
+			out->pad = 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif
@@ -21,6 +21,29 @@ static const char *const cursor_theme = "nein";
 static const char *const select_term_app_id = "st-wl-256color";
 static const char *const term = "st-wl";
 
+/* how many select_term_app_id terminals to keep started but unmapped, so
+ * the 1-3 chord can show one right away. 0 starts every terminal on demand */
+static const int term_pool_size = 1;
+
+/* how long a 1-3 selection waits for its terminal's window */
+static const int spawn_timeout_ms = 10000;
+
+/* arguments that start a 1-3 chord terminal at the selected size, so its
+ * first frame already fits. %c is replaced by columns, %r by rows
+ * - for st-wl: { "-g", "%cx%r", NULL }
+ * - for alacritty: { "-o", "window.dimensions.columns=%c", "-o", "window.dimensions.lines=%r", NULL }
+ * - { NULL } to start at the default size and resize afterwards
+ * the cell size and padding must match your terminal's font and border
+ */
+static const char *const term_geometry_args[] = { "-g", "%cx%r", NULL };
+static const uint32_t term_cell_width = 7;
+static const uint32_t term_cell_height = 15;
+static const uint32_t term_padding = 2;
+
+/* how long a sized or pooled terminal may stay hidden waiting for a frame of
+ * the selected size */
+static const int spawn_map_timeout_ms = 150;
+
 /* a flag for your terminal emulator to setup a windowid 
  * - for havoc: -i
  * - for st-wl: -w
@@ -31,6 +54,10 @@ static const char *const term_flag = "-w";
 /* gui programs take over the geometry of the terminal, broken for xwayland */
 static const bool enable_terminal_spawning = true;
 
+/* how long a process parent is trusted on kernels without pidfd_open, which
+ * otherwise tells mura when the process is gone */
+static const int proc_cache_ttl_ms = 2000;
+
 /* define a list of terminals that you use */
 static const char *const terminal_app_ids[] = {
 	"havoc",
@@ -45,6 +72,23 @@ static const int32_t move_scroll_edge_threshold = 80;
 static const int32_t move_scroll_speed = 16;
 static const float move_ease_factor = 0.30f;
 
+/* move chord mode:
+ * - true  : the window follows the pointer 1:1 on every motion, and the edge
+ *           scroll speed grows with how deep the pointer is into the edge band
+ * - false : every frame the window eases move_ease_factor of the way to the
+ *           pointer, and the edges scroll at a fixed move_scroll_speed
+ */
+static const bool move_follow_pointer = true;
+
+/* resize chord mode:
+ * - true  : outline the new size while dragging and configure the client at
+ *           most once per frame, waiting for it to catch up in between
+ * - false : let swc configure the client on every pointer motion
+ */
+static const bool resize_coalesce = true;
+/* how long a configure may go unanswered before the next goes out anyway */
+static const int resize_ack_timeout_ms = 250;
+
 /* scroll chord mode:
  * - true  : drag mouse to scroll in any direction
  * - false : use scroll wheel for vertical scrolling only
@@ -64,6 +108,33 @@ static bool focus_center = true;
  */
 static const bool enable_zoom = true;
 
+/* touchpad gestures: three finger swipes pan the plane, pinches zoom.
+ * mura reads them from the touchpad's event node itself, so it needs read
+ * access to it (e.g. by being in the input group)
+ * - gesture_natural : the plane follows the fingers
+ * - gesture_fling   : keep panning after a quick swipe
+ */
+static const bool enable_gestures = true;
+static const bool gesture_natural = true;
+static const bool gesture_fling = true;
+
+/* how many records mura -t keeps in its trace ring, rounded up to a power
+ * of two, 24 bytes each. extra/mura-trace turns the ring into a timeline */
+static const uint32_t trace_ring_records = 1 << 16;
+
+/* handlers that run longer than this many ms are traced and reported on
+ * stderr (at most once a second), 0 turns the watchdog off */
+static const uint32_t slow_handler_ms = 8;
+
+/* time every client request and keep histograms per request and per client
+ * pid, for mura-stat. costs a clock read per request. each window's commits,
+ * damage and frame callbacks are counted for mura-top either way */
+static const bool profile_requests = true;
+
+/* listen for line commands on $XDG_RUNTIME_DIR/<wayland socket>.mura, for
+ * scripts and extra/mura-ctl to read and move windows, scroll and zoom */
+static const bool control_socket = true;
+
 /* customizable 2-1 chord
  * avaliable options:
  * - STICKY: make window not move when scroll
@@ -26,11 +26,14 @@
 /* note from dalem: totally janky hack, see readme todo */
 
 #include <errno.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include <sys/signalfd.h>
 #include <time.h>
 #include <wayland-client.h>
@@ -46,19 +49,37 @@ enum align {
 	ALIGN_RIGHT,
 };
 
+/* wld's surfaces keep two buffers, one more leaves room */
+#define BAR_BUFFERS 3
+/* stretches of the bar repainted in one frame before it is repainted whole */
+#define BAR_SPANS 8
+
+/* where an item was and what it showed */
+struct item_state {
+	uint32_t serial, x, width;
+};
+
 struct item {
 	const struct item_interface *interface;
 	const struct item_data *data;
 	struct wl_list link;
+	uint32_t x;
+	struct item_state shown;              /* in the last frame */
+	struct item_state drawn[BAR_BUFFERS]; /* in each of the bar's buffers */
 };
 
 struct item_data {
 	uint32_t width;
+	uint32_t serial; /* changes whenever the item looks different */
 };
 
 struct text_item_data {
 	struct item_data base;
-	const char *text;
+	char text[32];
+};
+
+struct span {
+	uint32_t x0, x1;
 };
 
 struct status_bar {
@@ -68,6 +89,16 @@ struct status_bar {
 	struct wld_surface *wld_surface;
 	uint32_t width, height;
 
+	/* the buffers wld has handed out, each still holding the frame it was
+	 * last drawn with */
+	struct wld_buffer *buffers[BAR_BUFFERS];
+	unsigned next_buffer;
+
+	/* set from a draw until the compositor has shown it; whatever changes
+	 * meanwhile is drawn once it is done */
+	struct wl_callback *frame;
+	bool dirty;
+
 	struct wl_list items[3];
 };
 
@@ -91,17 +122,124 @@ static void registry_global(void *data, struct wl_registry *registry,
 static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t name);
 
 static void panel_docked(void *data, struct swc_panel *panel, uint32_t length);
+static void frame_done(void *data, struct wl_callback *callback, uint32_t time);
 static void mura_bar_scroll(void *data, struct mura_scroll *hscroll, int32_t pos);
+static void mura_bar_position(void *data, struct mura_scroll *hscroll,
+                              int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo);
+static void mura_bar_zoom(void *data, struct mura_scroll *hscroll, wl_fixed_t zoom);
+static void mura_bar_focus(void *data, struct mura_scroll *hscroll, uint32_t id);
+static void mura_bar_done(void *data, struct mura_scroll *hscroll);
+
+static void map_window(void *data, struct mura_windows *windows, uint32_t id, int32_t pid);
+static void map_geometry(void *data, struct mura_windows *windows, uint32_t id,
+                         int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo,
+                         uint32_t width, uint32_t height);
+static void map_title(void *data, struct mura_windows *windows, uint32_t id, const char *title);
+static void map_visible(void *data, struct mura_windows *windows, uint32_t id, uint32_t visible);
+static void map_closed(void *data, struct mura_windows *windows, uint32_t id);
+static void map_focus(void *data, struct mura_windows *windows, uint32_t id);
+static void map_camera(void *data, struct mura_windows *windows,
+                       int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo);
+static void map_view(void *data, struct mura_windows *windows,
+                     int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo,
+                     uint32_t width, uint32_t height);
+static void map_done(void *data, struct mura_windows *windows);
+
+static void seat_capabilities(void *data, struct wl_seat *seat, uint32_t capabilities);
+static void seat_name(void *data, struct wl_seat *seat, const char *name);
+static void pointer_enter(void *data, struct wl_pointer *pointer, uint32_t serial,
+                          struct wl_surface *surface, wl_fixed_t x, wl_fixed_t y);
+static void pointer_leave(void *data, struct wl_pointer *pointer, uint32_t serial,
+                          struct wl_surface *surface);
+static void pointer_motion(void *data, struct wl_pointer *pointer, uint32_t time,
+                           wl_fixed_t x, wl_fixed_t y);
+static void pointer_button(void *data, struct wl_pointer *pointer, uint32_t serial,
+                           uint32_t time, uint32_t button, uint32_t state);
+static void pointer_axis(void *data, struct wl_pointer *pointer, uint32_t time,
+                         uint32_t axis, wl_fixed_t value);
 
 /* Item interfaces */
 struct scroll {
 	struct mura_scroll *scroll;
-	int32_t pos;
+	uint32_t version;
+	int64_t x, y;
+	double zoom;
 };
 
 static struct scroll mura;
 
+/* a window as the minimap knows it, x and y on the plane */
+struct map_window {
+	uint32_t id;
+	int64_t x, y;
+	uint32_t width, height;
+	bool visible;
+	bool counted;          /* in the grid, over cells[] */
+	uint16_t cells[4];     /* x0, y0, x1, y1, the ends excluded */
+};
+
+/* the minimap keeps, for every cell, how many windows cover it as a 2d
+ * difference grid: a window adds or takes away its rectangle with four
+ * writes, however big it is, and drawing sums the grid up in one pass. so
+ * a window event costs the same with ten windows or ten thousand, and a
+ * frame costs the cells */
+struct minimap {
+	struct item_data base;
+	struct mura_windows *windows;
+	struct map_window *list; /* by id */
+	size_t n, cap;
+	uint32_t focus;
+	int64_t view_x, view_y;
+	uint32_t view_width, view_height;
+	bool have_view, changed;
+	/* of the windows alone, found again only when one of them changed */
+	int64_t bounds[4];
+	bool have_bounds, moved;
+	/* cell 0, 0 is at ox, oy on the plane, a cell is 2^shift pixels a side */
+	int64_t ox, oy;
+	unsigned shift;
+	uint32_t rows;
+	int32_t *diff; /* (map_width + 1) x (rows + 1) */
+	int32_t *sums; /* a row of column sums while drawing */
+};
+
+static struct minimap map;
+
+static struct {
+	struct wl_seat *seat;
+	struct wl_pointer *pointer;
+	struct status_bar *bar; /* the bar it is over, if any */
+	int32_t x, y;
+	bool pressed;
+} pointer;
+
+/* a status source. update runs on the module's own thread, every interval,
+ * and may block as long as it likes: the bar never waits for it */
+struct module {
+	void (*update)(char *text, size_t size);
+	uint32_t interval_ms;
+};
+
+/* the text goes from the module's thread to the bar through three slots.
+ * the thread fills its back slot and swaps it with the shared one, the bar
+ * swaps its front slot with the shared one when that holds something new.
+ * both swaps are one atomic exchange, so neither side ever waits */
+#define SLOT_FRESH 4
+
+struct module_state {
+	const struct module *module;
+	struct text_item_data data;
+	char slots[3][sizeof(((struct text_item_data *)0)->text)];
+	uint8_t back, front;
+	uint8_t shared; /* a slot, with SLOT_FRESH set while the bar has not taken it */
+	pthread_t thread;
+};
+
+static void module_load(char *text, size_t size);
+static void module_battery(char *text, size_t size);
+
 static void text_draw(struct status_bar *status_bar, struct item *item, uint32_t x, uint32_t y);
+static void map_draw(struct status_bar *status_bar, struct item *item, uint32_t x, uint32_t y);
 
 static struct wl_display *display;
 static struct wl_registry *registry;
@@ -126,26 +264,77 @@ static const struct swc_panel_listener panel_listener = {
 	.docked = &panel_docked
 };
 
+static const struct wl_callback_listener frame_listener = {
+	.done = &frame_done
+};
+
 static const struct item_interface text_interface = {
 	.draw = &text_draw
 };
 
+static const struct item_interface map_interface = {
+	.draw = &map_draw
+};
+
 static const struct mura_scroll_listener mura_scroll_listener = {
 	.get_pos = mura_bar_scroll,
+	.position = mura_bar_position,
+	.zoom = mura_bar_zoom,
+	.focus = mura_bar_focus,
+	.done = mura_bar_done,
+};
+
+static const struct mura_windows_listener mura_windows_listener = {
+	.window = map_window,
+	.geometry = map_geometry,
+	.title = map_title,
+	.app_id = map_title,
+	.visible = map_visible,
+	.closed = map_closed,
+	.focus = map_focus,
+	.camera = map_camera,
+	.view = map_view,
+	.done = map_done,
+};
+
+static const struct wl_seat_listener seat_listener = {
+	.capabilities = seat_capabilities,
+	.name = seat_name,
+};
+
+static const struct wl_pointer_listener pointer_listener = {
+	.enter = pointer_enter,
+	.leave = pointer_leave,
+	.motion = pointer_motion,
+	.button = pointer_button,
+	.axis = pointer_axis,
 };
 
 /* Configuration parameters */
 static const int spacing = 1;
 static const char *const font_name = "Terminus:pixelsize=14";
+static const uint32_t scroll_rate = 30; /* position updates a second, 0 for every frame */
 static const struct style normal = { .bg = 0xff1a1a1a, .fg = 0xff999999 };
+static const uint32_t map_width = 96; /* minimap pixels, each a cell of the plane, 0 for none */
+static const uint32_t map_window_color = 0xff4a4a4a, map_focus_color = 0xff999999;
+static const uint32_t map_view_color = 0xffd0d0d0;
+/* shown left of the clock, in this order */
+static const struct module modules[] = {
+	{ module_load, 5000 },
+	{ module_battery, 30000 },
+};
 
-static char scroll_text[32];
-static struct text_item_data scroll_data = {.text = scroll_text };
+static struct text_item_data scroll_data;
 
 static timer_t timer;
 static bool running, need_draw;
-static char clock_text[32];
-static struct text_item_data clock_data = {.text = clock_text };
+static struct text_item_data clock_data;
+
+static struct module_state module_states[sizeof(modules) / sizeof(modules[0])];
+static int modules_fd = -1; /* an eventfd the module threads bump */
+
+/* advance of each ascii glyph plus one, 0 until it is first measured */
+static uint32_t glyph_advance[128];
 
 static void __attribute__((noreturn)) die(const char *const format, ...)
 {
@@ -174,7 +363,7 @@ item_new(const struct item_interface *interface, const struct item_data *data)
 {
 	struct item *item;
 
-	if (!(item = malloc(sizeof(*item))))
+	if (!(item = calloc(1, sizeof(*item))))
 		die("Failed to allocate item");
 
 	item->interface = interface;
@@ -183,13 +372,39 @@ item_new(const struct item_interface *interface, const struct item_data *data)
 	return item;
 }
 
-static void
-update_text_item_data(struct text_item_data *data)
+static uint32_t
+text_width(const char *text)
 {
 	struct wld_extents extents;
+	const unsigned char *s;
+	char glyph[2] = { 0 };
+	uint32_t width = 0;
+
+	for (s = (const unsigned char *)text; *s; s++) {
+		/* anything past ascii is measured whole by wld */
+		if (*s >= 128) {
+			wld_font_text_extents(wld.font, text, &extents);
+			return extents.advance;
+		}
+		if (!glyph_advance[*s]) {
+			glyph[0] = (char)*s;
+			wld_font_text_extents(wld.font, glyph, &extents);
+			glyph_advance[*s] = extents.advance + 1;
+		}
+		width += glyph_advance[*s] - 1;
+	}
+	return width;
+}
 
-	wld_font_text_extents(wld.font, data->text, &extents);
-	data->base.width = extents.advance + spacing;
+/* the same text again is neither measured nor drawn */
+static void
+update_text_item_data(struct text_item_data *data, const char *text)
+{
+	if (data->base.serial && strcmp(data->text, text) == 0)
+		return;
+	snprintf(data->text, sizeof(data->text), "%s", text);
+	data->base.width = text_width(data->text) + spacing;
+	data->base.serial++;
 	need_draw = true;
 }
 
@@ -210,10 +425,19 @@ registry_global(void *data, struct wl_registry *registry,
 		if (!screen->swc)
 			die("Failed to bind swc_screen");
 		wl_list_insert(screens.prev, &screen->link);
+	} else if (strcmp(interface, "wl_seat") == 0 && !pointer.seat) {
+		pointer.seat = wl_registry_bind(registry, name, &wl_seat_interface, 1);
+		wl_seat_add_listener(pointer.seat, &seat_listener, NULL);
+	} else if (strcmp(interface, "mura_windows") == 0 && version >= 2 && map_width) {
+		map.windows = wl_registry_bind(registry, name, &mura_windows_interface, 2);
+		mura_windows_add_listener(map.windows, &mura_windows_listener, NULL);
 	} else if(strcmp(interface, "mura_scroll") == 0) {
-		mura.scroll = wl_registry_bind(registry, name, &mura_scroll_interface, 1);
-		mura.pos = 0;
+		mura.version = version < 2 ? version : 2;
+		mura.scroll = wl_registry_bind(registry, name, &mura_scroll_interface, mura.version);
+		mura.zoom = 1;
 		mura_scroll_add_listener(mura.scroll, &mura_scroll_listener, NULL);
+		if (mura.version >= 2)
+			mura_scroll_set_rate(mura.scroll, scroll_rate);
 	}
 }
 
@@ -242,6 +466,74 @@ text_draw(struct status_bar *bar, struct item *item, uint32_t x, uint32_t y)
 	wld_draw_text(wld.renderer, wld.font, normal.fg, x, y + wld.font->ascent + 1, data->text, -1, NULL);
 }
 
+#define bar_for_each_item(bar, align, item) \
+	for (align = 0; align < 3; align++) \
+		wl_list_for_each (item, &(bar)->items[align], link)
+
+static struct item_state
+item_state(const struct item *item)
+{
+	return (struct item_state){ item->data->serial, item->x, item->data->width };
+}
+
+static bool
+item_state_equal(struct item_state a, struct item_state b)
+{
+	return a.serial == b.serial && a.x == b.x && a.width == b.width;
+}
+
+static bool
+span_overlaps(const struct span *span, uint32_t x0, uint32_t x1)
+{
+	return x0 < span->x1 && span->x0 < x1;
+}
+
+/* adds [x0, x1), merged with every span it touches. false once there are
+ * too many to keep apart */
+static bool
+span_add(struct span *spans, unsigned *n, uint32_t x0, uint32_t x1)
+{
+	unsigned i = 0;
+
+	if (x0 >= x1)
+		return true;
+	while (i < *n) {
+		if (x0 <= spans[i].x1 && spans[i].x0 <= x1) {
+			x0 = x0 < spans[i].x0 ? x0 : spans[i].x0;
+			x1 = x1 > spans[i].x1 ? x1 : spans[i].x1;
+			spans[i] = spans[--*n];
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+	if (*n == BAR_SPANS)
+		return false;
+	spans[(*n)++] = (struct span){ x0, x1 };
+	return true;
+}
+
+/* the slot of a buffer from wld_surface_take(). one not seen before holds
+ * nothing worth keeping */
+static unsigned
+bar_buffer(struct status_bar *bar, struct wld_buffer *buffer, bool *fresh)
+{
+	unsigned i;
+
+	for (i = 0; i < BAR_BUFFERS; i++) {
+		if (bar->buffers[i] == buffer) {
+			*fresh = false;
+			return i;
+		}
+	}
+	i = bar->next_buffer++ % BAR_BUFFERS;
+	bar->buffers[i] = buffer;
+	*fresh = true;
+	return i;
+}
+
+/* repaints only the items that differ from what the buffer holds, and
+ * damages only the items that differ from the last frame */
 static void
 draw(struct status_bar *bar)
 {
@@ -250,9 +542,14 @@ draw(struct status_bar *bar)
 		0, (bar->width / 4), bar->width
 	};
 	uint32_t x;
+	struct span spans[BAR_SPANS];
+	struct wld_buffer *buffer;
+	struct item_state now, old;
+	unsigned i, n = 0, slot;
+	bool full, changed = false, grew;
+	int align;
 
-	wld_set_target_surface(wld.renderer, bar->wld_surface);
-	wld_fill_rectangle(wld.renderer, normal.bg, 0, 0, bar->width, bar->height);
+	bar->dirty = false;
 
 	wl_list_for_each (item, &bar->items[ALIGN_CENTER], link)
 		start_x[ALIGN_CENTER] -= item->data->width / 2;
@@ -260,38 +557,647 @@ draw(struct status_bar *bar)
 	wl_list_for_each (item, &bar->items[ALIGN_RIGHT], link)
 		start_x[ALIGN_RIGHT] -= item->data->width;
 
-	x = start_x[ALIGN_LEFT];
-	wl_list_for_each (item, &bar->items[ALIGN_LEFT], link) {
-		item->interface->draw(bar, item, x, 0);
-		x += item->data->width;
+	for (align = 0; align < 3; align++) {
+		x = start_x[align];
+		wl_list_for_each (item, &bar->items[align], link) {
+			item->x = x;
+			x += item->data->width;
+		}
 	}
 
-	x = start_x[ALIGN_CENTER];
-	wl_list_for_each (item, &bar->items[ALIGN_CENTER], link) {
-		item->interface->draw(bar, item, x, 0);
-		x += item->data->width;
+	bar_for_each_item (bar, align, item)
+		changed |= !item_state_equal(item->shown, item_state(item));
+	if (!changed)
+		return;
+
+	if (!(buffer = wld_surface_take(bar->wld_surface)))
+		return;
+	slot = bar_buffer(bar, buffer, &full);
+	wld_set_target_buffer(wld.renderer, buffer);
+
+	/* what moved or changed since this buffer was drawn, then the whole of
+	 * every item partly under that, text is never drawn over itself */
+	bar_for_each_item (bar, align, item) {
+		now = item_state(item);
+		old = item->drawn[slot];
+		if (!full && !item_state_equal(old, now))
+			full = !span_add(spans, &n, old.x, old.x + old.width) ||
+			       !span_add(spans, &n, now.x, now.x + now.width);
+	}
+	do {
+		grew = false;
+		bar_for_each_item (bar, align, item) {
+			for (i = 0; i < n && !full; i++) {
+				if (span_overlaps(&spans[i], item->x, item->x + item->data->width) &&
+				    (item->x < spans[i].x0 || item->x + item->data->width > spans[i].x1)) {
+					full = !span_add(spans, &n, item->x, item->x + item->data->width);
+					grew = true;
+					break;
+				}
+			}
+		}
+	} while (grew && !full);
+	if (full) {
+		spans[0] = (struct span){ 0, bar->width };
+		n = 1;
 	}
 
-	x = start_x[ALIGN_RIGHT];
-	wl_list_for_each (item, &bar->items[ALIGN_RIGHT], link) {
-		item->interface->draw(bar, item, x, 0);
-		x += item->data->width;
+	for (i = 0; i < n; i++) {
+		if (spans[i].x0 >= bar->width)
+			continue;
+		if (spans[i].x1 > bar->width)
+			spans[i].x1 = bar->width;
+		wld_fill_rectangle(wld.renderer, normal.bg, spans[i].x0, 0,
+		                   spans[i].x1 - spans[i].x0, bar->height);
+	}
+	bar_for_each_item (bar, align, item) {
+		now = item_state(item);
+		for (i = 0; i < n && now.width; i++) {
+			if (span_overlaps(&spans[i], now.x, now.x + now.width)) {
+				item->interface->draw(bar, item, now.x, 0);
+				break;
+			}
+		}
+		item->drawn[slot] = now;
 	}
 
-	wl_surface_damage(bar->surface, 0, 0, bar->width, bar->height);
+	if (full)
+		wl_surface_damage(bar->surface, 0, 0, bar->width, bar->height);
+	bar_for_each_item (bar, align, item) {
+		now = item_state(item);
+		old = item->shown;
+		if (!full && !item_state_equal(old, now)) {
+			if (old.width)
+				wl_surface_damage(bar->surface, old.x, 0, old.width, bar->height);
+			if (now.width)
+				wl_surface_damage(bar->surface, now.x, 0, now.width, bar->height);
+		}
+		item->shown = now;
+	}
 	wld_flush(wld.renderer);
+	bar->frame = wl_surface_frame(bar->surface);
+	wl_callback_add_listener(bar->frame, &frame_listener, bar);
 	wld_swap(bar->wld_surface);
 }
 
+/* a bar that is not on screen gets no callback and so is not drawn */
+static void
+frame_done(void *data, struct wl_callback *callback, uint32_t time)
+{
+	struct status_bar *bar = data;
+
+	wl_callback_destroy(callback);
+	bar->frame = NULL;
+	if (bar->dirty)
+		draw(bar);
+}
+
 static void
 mura_bar_scroll(void *data, struct mura_scroll *hscroll, int32_t pos)
 {
+	char text[sizeof(scroll_data.text)];
+
 	(void)data;
 	(void)hscroll;
 
-	mura.pos = pos;
-	snprintf(scroll_text, sizeof(scroll_text), "pos: %d", pos);
-	update_text_item_data(&scroll_data);
+	mura.y = pos;
+	snprintf(text, sizeof(text), "pos: %d", pos);
+	update_text_item_data(&scroll_data, text);
+}
+
+/* version 2 sends what changed, then done */
+static void
+mura_bar_position(void *data, struct mura_scroll *hscroll,
+                  int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo)
+{
+	(void)data;
+	(void)hscroll;
+
+	mura.x = (int64_t)((uint64_t)(uint32_t)x_hi << 32 | x_lo);
+	mura.y = (int64_t)((uint64_t)(uint32_t)y_hi << 32 | y_lo);
+}
+
+static void
+mura_bar_zoom(void *data, struct mura_scroll *hscroll, wl_fixed_t zoom)
+{
+	(void)data;
+	(void)hscroll;
+
+	mura.zoom = wl_fixed_to_double(zoom);
+}
+
+static void
+mura_bar_focus(void *data, struct mura_scroll *hscroll, uint32_t id)
+{
+	(void)data;
+	(void)hscroll;
+	(void)id;
+}
+
+static void
+mura_bar_done(void *data, struct mura_scroll *hscroll)
+{
+	char text[sizeof(scroll_data.text)];
+
+	(void)data;
+	(void)hscroll;
+
+	if (mura.zoom != 1)
+		snprintf(text, sizeof(text), "pos: %lld,%lld %d%%",
+		         (long long)mura.x, (long long)mura.y, (int)(mura.zoom * 100 + 0.5));
+	else
+		snprintf(text, sizeof(text), "pos: %lld,%lld",
+		         (long long)mura.x, (long long)mura.y);
+	update_text_item_data(&scroll_data, text);
+}
+
+/* Minimap */
+static struct map_window *
+map_find(uint32_t id, size_t *at)
+{
+	size_t lo = 0, hi = map.n, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (map.list[mid].id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (at)
+		*at = lo;
+	return lo < map.n && map.list[lo].id == id ? &map.list[lo] : NULL;
+}
+
+/* the cell a point of the plane falls in, clamped to the map */
+static uint16_t
+map_cell(int64_t v, int64_t origin, uint32_t cells)
+{
+	int64_t d = v - origin;
+
+	if (d <= 0)
+		return 0;
+	d >>= map.shift;
+	return (uint16_t)(d >= cells ? cells - 1 : d);
+}
+
+/* adds the window's cells to the grid, or takes them away */
+static void
+map_count(struct map_window *w, bool add)
+{
+	uint32_t stride = map_width + 1;
+	uint16_t *c = w->cells;
+	int32_t n = add ? 1 : -1;
+
+	if (!map.diff)
+		return;
+	if (add) {
+		if (!w->visible || !w->width || !w->height)
+			return;
+		c[0] = map_cell(w->x, map.ox, map_width);
+		c[1] = map_cell(w->y, map.oy, map.rows);
+		c[2] = map_cell(w->x + w->width - 1, map.ox, map_width) + 1;
+		c[3] = map_cell(w->y + w->height - 1, map.oy, map.rows) + 1;
+		w->counted = true;
+	} else {
+		if (!w->counted)
+			return;
+		w->counted = false;
+	}
+	map.diff[c[1] * stride + c[0]] += n;
+	map.diff[c[1] * stride + c[2]] -= n;
+	map.diff[c[3] * stride + c[0]] -= n;
+	map.diff[c[3] * stride + c[2]] += n;
+}
+
+/* what the map has to show: every visible window and the view */
+static bool
+map_bounds(int64_t b[4])
+{
+	struct map_window *w;
+	bool any = false;
+
+	if (!map.moved) {
+		memcpy(b, map.bounds, sizeof(map.bounds));
+		any = map.have_bounds;
+		goto view;
+	}
+	for (w = map.list; w < map.list + map.n; w++) {
+		if (!w->visible || !w->width || !w->height)
+			continue;
+		if (!any || w->x < b[0])
+			b[0] = w->x;
+		if (!any || w->y < b[1])
+			b[1] = w->y;
+		if (!any || w->x + w->width > b[2])
+			b[2] = w->x + w->width;
+		if (!any || w->y + w->height > b[3])
+			b[3] = w->y + w->height;
+		any = true;
+	}
+	memcpy(map.bounds, b, sizeof(map.bounds));
+	map.have_bounds = any;
+	map.moved = false;
+
+view:
+	if (map.have_view) {
+		if (!any || map.view_x < b[0])
+			b[0] = map.view_x;
+		if (!any || map.view_y < b[1])
+			b[1] = map.view_y;
+		if (!any || map.view_x + map.view_width > b[2])
+			b[2] = map.view_x + map.view_width;
+		if (!any || map.view_y + map.view_height > b[3])
+			b[3] = map.view_y + map.view_height;
+		any = true;
+	}
+	return any;
+}
+
+static bool
+map_fits(const int64_t b[4], int64_t ox, int64_t oy, unsigned shift)
+{
+	return b[0] >= ox && b[2] <= ox + ((int64_t)map_width << shift) &&
+	       b[1] >= oy && b[3] <= oy + ((int64_t)map.rows << shift);
+}
+
+/* picks the smallest power of two cell that shows everything, centred.
+ * a map that still fits is kept unless it is four times too big, so
+ * panning about only recounts the windows when the view leaves the map */
+static void
+map_layout(bool force)
+{
+	int64_t b[4], step, ox = 0, oy = 0;
+	unsigned shift = 0;
+
+	if (!map.diff || !map_bounds(b))
+		return;
+	if (!force && map_fits(b, map.ox, map.oy, map.shift) &&
+	    (map.shift < 2 || b[2] - b[0] > (int64_t)map_width << (map.shift - 2) ||
+	     b[3] - b[1] > (int64_t)map.rows << (map.shift - 2)))
+		return;
+
+	for (; shift < 48; shift++) {
+		step = (int64_t)1 << shift;
+		ox = b[0] + (b[2] - b[0]) / 2 - ((int64_t)map_width << shift) / 2;
+		oy = b[1] + (b[3] - b[1]) / 2 - ((int64_t)map.rows << shift) / 2;
+		ox -= (ox % step + step) % step;
+		oy -= (oy % step + step) % step;
+		if (map_fits(b, ox, oy, shift))
+			break;
+	}
+	map.ox = ox;
+	map.oy = oy;
+	map.shift = shift;
+	memset(map.diff, 0, (map_width + 1) * (map.rows + 1) * sizeof(*map.diff));
+	for (size_t i = 0; i < map.n; i++) {
+		map.list[i].counted = false;
+		map_count(&map.list[i], true);
+	}
+}
+
+/* once the bars' height is known, they all have the same */
+static void
+map_init(uint32_t height)
+{
+	if (!map.windows || map.diff || height < 4)
+		return;
+	map.rows = height - 2;
+	map.diff = calloc((map_width + 1) * (map.rows + 1), sizeof(*map.diff));
+	map.sums = calloc(map_width + 1, sizeof(*map.sums));
+	if (!map.diff || !map.sums)
+		die("Failed to allocate the minimap");
+	map.base.width = map_width + spacing;
+	map.base.serial++;
+	map_layout(true);
+	need_draw = true;
+}
+
+static void
+map_window(void *data, struct mura_windows *windows, uint32_t id, int32_t pid)
+{
+	struct map_window *list;
+	size_t at;
+
+	if (map_find(id, &at))
+		return;
+	if (map.n == map.cap) {
+		map.cap = map.cap ? map.cap * 2 : 64;
+		if (!(list = realloc(map.list, map.cap * sizeof(*list))))
+			die("Failed to allocate the minimap");
+		map.list = list;
+	}
+	memmove(&map.list[at + 1], &map.list[at], (map.n - at) * sizeof(*map.list));
+	map.list[at] = (struct map_window){ .id = id, .visible = true };
+	map.n++;
+}
+
+static void
+map_geometry(void *data, struct mura_windows *windows, uint32_t id,
+             int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo,
+             uint32_t width, uint32_t height)
+{
+	struct map_window *w;
+
+	if (!(w = map_find(id, NULL)))
+		return;
+	map_count(w, false);
+	w->x = (int64_t)((uint64_t)(uint32_t)x_hi << 32 | x_lo);
+	w->y = (int64_t)((uint64_t)(uint32_t)y_hi << 32 | y_lo);
+	w->width = width;
+	w->height = height;
+	map_count(w, true);
+	map.changed = map.moved = true;
+}
+
+static void
+map_title(void *data, struct mura_windows *windows, uint32_t id, const char *title)
+{
+}
+
+static void
+map_visible(void *data, struct mura_windows *windows, uint32_t id, uint32_t visible)
+{
+	struct map_window *w;
+
+	if (!(w = map_find(id, NULL)))
+		return;
+	map_count(w, false);
+	w->visible = visible;
+	map_count(w, true);
+	map.changed = map.moved = true;
+}
+
+static void
+map_closed(void *data, struct mura_windows *windows, uint32_t id)
+{
+	struct map_window *w;
+
+	if (!(w = map_find(id, NULL)))
+		return;
+	map_count(w, false);
+	memmove(w, w + 1, (size_t)(map.list + map.n - (w + 1)) * sizeof(*w));
+	map.n--;
+	map.changed = map.moved = true;
+}
+
+static void
+map_focus(void *data, struct mura_windows *windows, uint32_t id)
+{
+	map.focus = id;
+	map.changed = true;
+}
+
+/* the view carries the camera already */
+static void
+map_camera(void *data, struct mura_windows *windows,
+           int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo)
+{
+}
+
+static void
+map_view(void *data, struct mura_windows *windows,
+         int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo,
+         uint32_t width, uint32_t height)
+{
+	map.view_x = (int64_t)((uint64_t)(uint32_t)x_hi << 32 | x_lo);
+	map.view_y = (int64_t)((uint64_t)(uint32_t)y_hi << 32 | y_lo);
+	map.view_width = width;
+	map.view_height = height;
+	map.have_view = true;
+	map.changed = true;
+}
+
+static void
+map_done(void *data, struct mura_windows *windows)
+{
+	if (!map.changed)
+		return;
+	map.changed = false;
+	map_layout(false);
+	map.base.serial++;
+	need_draw = true;
+}
+
+void
+map_draw(struct status_bar *bar, struct item *item, uint32_t x, uint32_t y)
+{
+	uint32_t stride = map_width + 1, cx, cy, start;
+	struct map_window *w;
+	uint16_t v[4];
+	int32_t count;
+
+	y += 1;
+	/* a running sum down each column, then along the row, gives how many
+	 * windows cover each cell; covered cells go out as runs */
+	memset(map.sums, 0, stride * sizeof(*map.sums));
+	for (cy = 0; cy < map.rows; cy++) {
+		count = 0;
+		start = 0;
+		for (cx = 0; cx <= map_width; cx++) {
+			map.sums[cx] += map.diff[cy * stride + cx];
+			if (cx < map_width && (count += map.sums[cx]) > 0)
+				continue;
+			if (cx > start)
+				wld_fill_rectangle(wld.renderer, map_window_color, x + start, y + cy, cx - start, 1);
+			start = cx + 1;
+		}
+	}
+
+	if ((w = map_find(map.focus, NULL)) && w->counted)
+		wld_fill_rectangle(wld.renderer, map_focus_color, x + w->cells[0], y + w->cells[1],
+		                   w->cells[2] - w->cells[0], w->cells[3] - w->cells[1]);
+
+	if (!map.have_view || !map.view_width || !map.view_height)
+		return;
+	v[0] = map_cell(map.view_x, map.ox, map_width);
+	v[1] = map_cell(map.view_y, map.oy, map.rows);
+	v[2] = map_cell(map.view_x + map.view_width - 1, map.ox, map_width);
+	v[3] = map_cell(map.view_y + map.view_height - 1, map.oy, map.rows);
+	wld_fill_rectangle(wld.renderer, map_view_color, x + v[0], y + v[1], v[2] - v[0] + 1, 1);
+	wld_fill_rectangle(wld.renderer, map_view_color, x + v[0], y + v[3], v[2] - v[0] + 1, 1);
+	wld_fill_rectangle(wld.renderer, map_view_color, x + v[0], y + v[1], 1, v[3] - v[1] + 1);
+	wld_fill_rectangle(wld.renderer, map_view_color, x + v[2], y + v[1], 1, v[3] - v[1] + 1);
+}
+
+/* a click or a drag on the minimap pans there */
+static void
+map_look(void)
+{
+	struct item *item;
+	int64_t px, py;
+	int align;
+
+	if (!pointer.bar || !map.windows || !map.diff)
+		return;
+	bar_for_each_item (pointer.bar, align, item) {
+		if (item->data != &map.base)
+			continue;
+		if (pointer.x < (int32_t)item->x || pointer.x >= (int32_t)(item->x + map_width) ||
+		    pointer.y < 1 || pointer.y >= (int32_t)map.rows + 1)
+			return;
+		px = map.ox + ((int64_t)(pointer.x - item->x) << map.shift) + ((int64_t)1 << map.shift) / 2;
+		py = map.oy + ((int64_t)(pointer.y - 1) << map.shift) + ((int64_t)1 << map.shift) / 2;
+		mura_windows_look_at(map.windows, (int32_t)(px >> 32), (uint32_t)px,
+		                     (int32_t)(py >> 32), (uint32_t)py);
+		return;
+	}
+}
+
+static void
+seat_capabilities(void *data, struct wl_seat *seat, uint32_t capabilities)
+{
+	if ((capabilities & WL_SEAT_CAPABILITY_POINTER) && !pointer.pointer) {
+		pointer.pointer = wl_seat_get_pointer(seat);
+		wl_pointer_add_listener(pointer.pointer, &pointer_listener, NULL);
+	} else if (!(capabilities & WL_SEAT_CAPABILITY_POINTER) && pointer.pointer) {
+		wl_pointer_destroy(pointer.pointer);
+		pointer.pointer = NULL;
+		pointer.bar = NULL;
+	}
+}
+
+static void
+seat_name(void *data, struct wl_seat *seat, const char *name)
+{
+}
+
+static void
+pointer_enter(void *data, struct wl_pointer *p, uint32_t serial,
+              struct wl_surface *surface, wl_fixed_t x, wl_fixed_t y)
+{
+	pointer.bar = wl_surface_get_user_data(surface);
+	pointer.x = wl_fixed_to_int(x);
+	pointer.y = wl_fixed_to_int(y);
+	pointer.pressed = false;
+}
+
+static void
+pointer_leave(void *data, struct wl_pointer *p, uint32_t serial, struct wl_surface *surface)
+{
+	pointer.bar = NULL;
+	pointer.pressed = false;
+}
+
+static void
+pointer_motion(void *data, struct wl_pointer *p, uint32_t time, wl_fixed_t x, wl_fixed_t y)
+{
+	pointer.x = wl_fixed_to_int(x);
+	pointer.y = wl_fixed_to_int(y);
+	if (pointer.pressed)
+		map_look();
+}
+
+static void
+pointer_button(void *data, struct wl_pointer *p, uint32_t serial,
+               uint32_t time, uint32_t button, uint32_t state)
+{
+	pointer.pressed = state == WL_POINTER_BUTTON_STATE_PRESSED;
+	if (pointer.pressed)
+		map_look();
+}
+
+static void
+pointer_axis(void *data, struct wl_pointer *p, uint32_t time, uint32_t axis, wl_fixed_t value)
+{
+}
+
+/* Status modules */
+static void *
+module_run(void *data)
+{
+	struct module_state *m = data;
+	const struct module *module = m->module;
+	struct timespec next;
+	uint64_t one = 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (;;) {
+		m->slots[m->back][0] = '\0';
+		module->update(m->slots[m->back], sizeof(m->slots[0]));
+		m->slots[m->back][sizeof(m->slots[0]) - 1] = '\0';
+		m->back = __atomic_exchange_n(&m->shared, m->back | SLOT_FRESH, __ATOMIC_ACQ_REL) & 3;
+		if (write(modules_fd, &one, sizeof(one)) < 0) {
+			/* counter full, a wakeup is already pending */
+		}
+
+		next.tv_sec += module->interval_ms / 1000;
+		next.tv_nsec += (long)(module->interval_ms % 1000) * 1000000;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000;
+		}
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+			;
+	}
+	return NULL;
+}
+
+/* the threads take the signal mask they are started with, so this waits
+ * until SIGALRM is blocked for the clock's signalfd */
+static void
+modules_start(void)
+{
+	for (size_t i = 0; i < sizeof(modules) / sizeof(modules[0]); i++) {
+		if (pthread_create(&module_states[i].thread, NULL, module_run, &module_states[i]) != 0)
+			die("Failed to start a status module");
+	}
+}
+
+static void
+modules_collect(void)
+{
+	struct module_state *m;
+	uint64_t count;
+
+	if (read(modules_fd, &count, sizeof(count)) < 0)
+		return;
+	for (size_t i = 0; i < sizeof(modules) / sizeof(modules[0]); i++) {
+		m = &module_states[i];
+		if (!(__atomic_load_n(&m->shared, __ATOMIC_RELAXED) & SLOT_FRESH))
+			continue;
+		m->front = __atomic_exchange_n(&m->shared, m->front, __ATOMIC_ACQ_REL) & 3;
+		update_text_item_data(&m->data, m->slots[m->front]);
+	}
+}
+
+/* the first line of a file, without its newline */
+static bool
+read_line(const char *path, char *line, size_t size)
+{
+	FILE *file;
+	bool ok;
+
+	if (!(file = fopen(path, "r")))
+		return false;
+	ok = fgets(line, (int)size, file) != NULL;
+	fclose(file);
+	if (ok)
+		line[strcspn(line, "\n")] = '\0';
+	return ok;
+}
+
+static void
+module_load(char *text, size_t size)
+{
+	char line[64];
+
+	if (read_line("/proc/loadavg", line, sizeof(line)))
+		snprintf(text, size, "load %.*s ", (int)strcspn(line, " "), line);
+}
+
+static void
+module_battery(char *text, size_t size)
+{
+	char capacity[16], status[32];
+
+	if (!read_line("/sys/class/power_supply/BAT0/capacity", capacity, sizeof(capacity)))
+		return;
+	if (read_line("/sys/class/power_supply/BAT0/status", status, sizeof(status)) &&
+	    strcmp(status, "Charging") == 0)
+		snprintf(text, size, "bat %s%%+ ", capacity);
+	else
+		snprintf(text, size, "bat %s%% ", capacity);
 }
 
 static void
@@ -309,6 +1215,15 @@ setup(void)
 	if (timer_create(CLOCK_MONOTONIC, NULL, &timer) != 0)
 		die("Failed to create timer: %s", strerror(errno));
 
+	if ((modules_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0)
+		die("Failed to create eventfd: %s", strerror(errno));
+	for (size_t i = 0; i < sizeof(modules) / sizeof(modules[0]); i++) {
+		module_states[i].module = &modules[i];
+		module_states[i].back = 0;
+		module_states[i].shared = 1;
+		module_states[i].front = 2;
+	}
+
 	if (!(display = wl_display_connect(NULL)))
 		die("Failed to connect to display");
 
@@ -345,6 +1260,7 @@ setup(void)
 
 		status_bar = &screen->status_bar;
 		status_bar->surface = wl_compositor_create_surface(compositor);
+		wl_surface_set_user_data(status_bar->surface, status_bar);
 		status_bar->panel = swc_panel_manager_create_panel(panel_manager, status_bar->surface);
 		swc_panel_add_listener(status_bar->panel, &panel_listener, status_bar);
 		swc_panel_dock(status_bar->panel, SWC_PANEL_EDGE_TOP, screen->swc, false);
@@ -366,9 +1282,22 @@ setup(void)
 		item = item_new(&text_interface, &clock_data.base);
 		wl_list_insert(items, &item->link);
 
+		/* Status modules, left of the clock */
+		for (size_t i = 0; i < sizeof(modules) / sizeof(modules[0]); i++) {
+			struct item *module = item_new(&text_interface, &module_states[i].data.base);
+
+			wl_list_insert(item->link.prev, &module->link);
+		}
+
 		items = &screen->status_bar.items[ALIGN_LEFT];
 		item = item_new(&text_interface, &scroll_data.base);
 		wl_list_insert(items, &item->link);
+
+		/* Minimap */
+		if (map.windows) {
+			item = item_new(&map_interface, &map.base);
+			wl_list_insert(screen->status_bar.items[ALIGN_CENTER].prev, &item->link);
+		}
 	}
 
 	/* Wait for dock notifications. */
@@ -378,6 +1307,7 @@ setup(void)
 		if (!screen->status_bar.wld_surface)
 			die("");
 		swc_panel_set_strut(screen->status_bar.panel, screen->status_bar.height, 0, screen->status_bar.width);
+		map_init(screen->status_bar.height);
 	}
 
 	fprintf(stderr, "done\n");
@@ -393,7 +1323,7 @@ run(void)
 		.it_interval = { 1, 0 },
 		.it_value = { 0, 1 }
 	};
-	struct pollfd fds[2];
+	struct pollfd fds[3];
 	struct screen *screen;
 
 	sigemptyset(&signals);
@@ -404,6 +1334,10 @@ run(void)
 	fds[0].events = POLLIN;
 	fds[1].fd = signalfd(-1, &signals, SFD_CLOEXEC);
 	fds[1].events = POLLIN;
+	fds[2].fd = modules_fd;
+	fds[2].events = POLLIN;
+
+	modules_start();
 
 	timer_settime(timer, 0, &timer_value, NULL);
 	running = true;
@@ -422,16 +1356,23 @@ run(void)
 		if (fds[1].revents & POLLIN) {
 			time_t raw_time = time(NULL);
 			struct tm *local_time = localtime(&raw_time);
+			char text[sizeof(clock_data.text)];
 
 			sigwaitinfo(&signals, NULL);
 
-			strftime(clock_text, sizeof(clock_text), "%A %T %F", local_time);
-			update_text_item_data(&clock_data);
+			strftime(text, sizeof(text), "%A %T %F", local_time);
+			update_text_item_data(&clock_data, text);
 		}
+		if (fds[2].revents & POLLIN)
+			modules_collect();
 
+		/* at most one draw a frame, the rest waits for frame_done */
 		if (need_draw) {
-			wl_list_for_each (screen, &screens, link)
-				draw(&screen->status_bar);
+			wl_list_for_each (screen, &screens, link) {
+				screen->status_bar.dirty = true;
+				if (!screen->status_bar.frame)
+					draw(&screen->status_bar);
+			}
 			need_draw = false;
 		}
 
@@ -0,0 +1,190 @@
+/* mura-cam: where the plane is, read from mura's camera page.
+ *
+ * usage: mura-cam [-w ms]
+ *   -w ms  keep reading every ms, print a line whenever the camera moved
+ *
+ * a line is "x y zoom focus", zoom as a fraction and focus as the window's
+ * mura-top id, so a script can read it with a single `read`.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <wayland-client.h>
+
+#include "mura-client-protocol.h"
+#include "../../camera.h"
+
+static struct mura_scroll *scroll;
+static int page_fd = -1;
+static uint32_t page_size;
+
+static void
+die(const char *msg)
+{
+	fprintf(stderr, "mura-cam: %s\n", msg);
+	exit(1);
+}
+
+static void
+scroll_get_pos(void *data, struct mura_scroll *s, int32_t pos)
+{
+	(void)data;
+	(void)s;
+	(void)pos;
+}
+
+static void
+scroll_position(void *data, struct mura_scroll *s,
+                int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo)
+{
+	(void)data;
+	(void)s;
+	(void)x_hi;
+	(void)x_lo;
+	(void)y_hi;
+	(void)y_lo;
+}
+
+static void
+scroll_zoom(void *data, struct mura_scroll *s, wl_fixed_t zoom)
+{
+	(void)data;
+	(void)s;
+	(void)zoom;
+}
+
+static void
+scroll_focus(void *data, struct mura_scroll *s, uint32_t id)
+{
+	(void)data;
+	(void)s;
+	(void)id;
+}
+
+static void
+scroll_done(void *data, struct mura_scroll *s)
+{
+	(void)data;
+	(void)s;
+}
+
+static void
+scroll_page(void *data, struct mura_scroll *s, int32_t fd, uint32_t size)
+{
+	(void)data;
+	(void)s;
+	page_fd = fd;
+	page_size = size;
+}
+
+static const struct mura_scroll_listener scroll_listener = {
+	.get_pos = scroll_get_pos,
+	.position = scroll_position,
+	.zoom = scroll_zoom,
+	.focus = scroll_focus,
+	.done = scroll_done,
+	.page = scroll_page,
+};
+
+static void
+registry_global(void *data, struct wl_registry *registry,
+                uint32_t name, const char *interface, uint32_t version)
+{
+	(void)data;
+
+	if (strcmp(interface, "mura_scroll") == 0 && version >= 3) {
+		scroll = wl_registry_bind(registry, name, &mura_scroll_interface, 3);
+		mura_scroll_add_listener(scroll, &scroll_listener, NULL);
+	}
+}
+
+static void
+registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+	(void)data;
+	(void)registry;
+	(void)name;
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = registry_global,
+	.global_remove = registry_global_remove,
+};
+
+static void
+print_camera(const struct camera_page *c)
+{
+	printf("%lld %lld %.3f %u\n", (long long)c->x, (long long)c->y,
+	       c->zoom / 65536.0, c->focus);
+	fflush(stdout);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct wl_display *display;
+	struct wl_registry *registry;
+	const struct camera_page *page;
+	struct camera_page now;
+	uint64_t seen = 0;
+	long interval = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "w:")) != -1) {
+		switch (c) {
+		case 'w':
+			interval = strtol(optarg, NULL, 10);
+			if (interval <= 0)
+				die("the interval has to be positive");
+			break;
+		default:
+			fprintf(stderr, "usage: mura-cam [-w ms]\n");
+			return 1;
+		}
+	}
+
+	if (!(display = wl_display_connect(NULL)))
+		die("cannot connect to the display");
+	registry = wl_display_get_registry(display);
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+	if (!scroll)
+		die("the compositor has no mura_scroll version 3");
+
+	mura_scroll_get_page(scroll);
+	wl_display_roundtrip(display);
+	if (page_fd < 0 || page_size < sizeof(*page))
+		die("the compositor sent no camera page");
+	page = mmap(NULL, page_size, PROT_READ, MAP_SHARED, page_fd, 0);
+	if (page == MAP_FAILED)
+		die("cannot map the camera page");
+	close(page_fd);
+
+	/* nothing else comes over the socket, the page is all there is */
+	mura_scroll_destroy(scroll);
+	wl_display_roundtrip(display);
+
+	do {
+		if (!camera_read(page, &now))
+			die("cannot read the camera page");
+		if (now.updates != seen) {
+			print_camera(&now);
+			seen = now.updates;
+		}
+		if (interval) {
+			struct timespec ts = { interval / 1000, (interval % 1000) * 1000000 };
+
+			nanosleep(&ts, NULL);
+		}
+	} while (interval);
+
+	munmap((void *)page, page_size);
+	wl_display_disconnect(display);
+	return 0;
+}
@@ -0,0 +1,169 @@
+/* mura-ctl: send commands to mura's control socket and print the replies.
+ *
+ * usage: mura-ctl [-b] [command ...]
+ *   -b  send everything as one batch, applied in a single frame
+ *
+ * each argument is one command line, with none they are read from stdin.
+ * the socket is $MURA_CTL, or $XDG_RUNTIME_DIR/$WAYLAND_DISPLAY.mura.
+ * exits 1 if any reply was an error.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+struct buf {
+	char *data;
+	size_t len, cap;
+};
+
+static void
+die(const char *msg)
+{
+	fprintf(stderr, "mura-ctl: %s\n", msg);
+	exit(1);
+}
+
+static void
+buf_add(struct buf *b, const char *s, size_t n)
+{
+	char *data;
+
+	if (b->len + n > b->cap) {
+		b->cap = (b->len + n) * 2;
+		if (!(data = realloc(b->data, b->cap)))
+			die("out of memory");
+		b->data = data;
+	}
+	memcpy(b->data + b->len, s, n);
+	b->len += n;
+}
+
+static int
+connect_mura(void)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	const char *path = getenv("MURA_CTL"), *dir, *display;
+	int fd, n;
+
+	if (path)
+		n = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+	else if ((dir = getenv("XDG_RUNTIME_DIR")))
+		n = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s.mura", dir,
+		             (display = getenv("WAYLAND_DISPLAY")) ? display : "wayland-0");
+	else
+		die("neither MURA_CTL nor XDG_RUNTIME_DIR is set");
+	if (n < 0 || (size_t)n >= sizeof(addr.sun_path))
+		die("the socket path is too long");
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		die("cannot make a socket");
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		fprintf(stderr, "mura-ctl: cannot connect to %s: %s\n", addr.sun_path, strerror(errno));
+		exit(1);
+	}
+	return fd;
+}
+
+/* replies are printed as they come, while the rest is still being sent.
+ * mura stops reading from a client whose replies pile up, so a blocking
+ * write could wait on it forever: the socket only gets what fits */
+static bool
+converse(int fd, const struct buf *out)
+{
+	struct pollfd pfd = { .fd = fd };
+	size_t sent = 0;
+	char in[4096];
+	bool error = false, line_start = true;
+	ssize_t n;
+
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+		die("cannot make the socket non-blocking");
+	if (out->len == 0)
+		shutdown(fd, SHUT_WR);
+	for (;;) {
+		pfd.events = POLLIN | (sent < out->len ? POLLOUT : 0);
+		if (poll(&pfd, 1, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			die("poll failed");
+		}
+		if (sent < out->len && (pfd.revents & POLLOUT)) {
+			n = send(fd, out->data + sent, out->len - sent, MSG_NOSIGNAL);
+			if (n < 0 && errno != EAGAIN && errno != EINTR)
+				die("lost mura while sending");
+			sent += n > 0 ? (size_t)n : 0;
+			if (sent == out->len)
+				shutdown(fd, SHUT_WR);
+		}
+		if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+			if ((n = read(fd, in, sizeof(in))) < 0) {
+				if (errno == EAGAIN || errno == EINTR)
+					continue;
+				die("lost mura while reading");
+			}
+			if (n == 0)
+				break;
+			/* replies start with ok or error */
+			for (ssize_t i = 0; i < n; i++) {
+				if (line_start && in[i] == 'e')
+					error = true;
+				line_start = in[i] == '\n';
+			}
+			fwrite(in, 1, (size_t)n, stdout);
+		}
+	}
+	if (sent < out->len)
+		die("mura hung up early");
+	return !error;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct buf out = { 0 };
+	bool batch = false;
+	char chunk[4096];
+	size_t n;
+	int c, fd;
+
+	while ((c = getopt(argc, argv, "b")) != -1) {
+		switch (c) {
+		case 'b':
+			batch = true;
+			break;
+		default:
+			fprintf(stderr, "usage: mura-ctl [-b] [command ...]\n");
+			return 1;
+		}
+	}
+
+	if (batch)
+		buf_add(&out, "begin\n", 6);
+	if (optind < argc) {
+		for (int i = optind; i < argc; i++) {
+			buf_add(&out, argv[i], strlen(argv[i]));
+			buf_add(&out, "\n", 1);
+		}
+	} else {
+		while ((n = fread(chunk, 1, sizeof(chunk), stdin)) > 0)
+			buf_add(&out, chunk, n);
+		if (out.len && out.data[out.len - 1] != '\n')
+			buf_add(&out, "\n", 1);
+	}
+	if (batch)
+		buf_add(&out, "commit\n", 7);
+
+	fd = connect_mura();
+	c = converse(fd, &out) ? 0 : 1;
+	close(fd);
+	free(out.data);
+	return c;
+}
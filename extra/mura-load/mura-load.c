@@ -0,0 +1,600 @@
+/* mura-load: open many busy wl_shm toplevels to load the compositor.
+ *
+ * every window draws into its own shm buffers and commits at a fixed rate
+ * or as fast as its frame callbacks allow. it measures, as a client sees
+ * it, how long a commit waits for its frame callback and how many frames
+ * it had to skip because the last one was still not done.
+ *
+ * usage: mura-load [-n windows] [-c clients] [-s WxH[-WxH]] [-r hz]
+ *                  [-d full|rect|none] [-a app_id] [-t title] [-T seconds] [-v]
+ */
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <wayland-client.h>
+
+#include "xdg-shell-client-protocol.h"
+#include "../../hist.h"
+
+enum damage {
+	DAMAGE_FULL,
+	DAMAGE_RECT, /* a square moving across the window */
+	DAMAGE_NONE, /* commit the same contents again */
+};
+
+struct buffer {
+	struct wl_buffer *wl;
+	uint32_t *pixels;
+	size_t size;
+	bool busy;
+};
+
+struct client;
+
+struct window {
+	struct client *client;
+	struct wl_surface *surface;
+	struct xdg_surface *xdg_surface;
+	struct xdg_toplevel *toplevel;
+	struct wl_callback *frame;
+	struct buffer buffers[2];
+	uint32_t width, height;
+	bool configured, resized;
+	uint32_t index, tick;
+	uint64_t committed_at, next_due;
+
+	uint64_t frames, dropped, starved;
+	struct hist latency;
+};
+
+/* one connection, which can own several windows */
+struct client {
+	struct wl_display *display;
+	struct wl_registry *registry;
+	struct wl_compositor *compositor;
+	struct wl_shm *shm;
+	struct xdg_wm_base *wm_base;
+};
+
+static struct {
+	uint32_t windows, clients;
+	uint32_t min_w, min_h, max_w, max_h;
+	uint32_t rate;
+	enum damage damage;
+	const char *app_id, *title;
+	uint32_t seconds;
+	bool verbose;
+} opt = { 16, 0, 400, 300, 400, 300, 0, DAMAGE_FULL, "mura-load", "load", 10, false };
+
+static struct client *clients;
+static struct window *windows;
+static volatile sig_atomic_t running = 1;
+
+static uint64_t
+now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void
+die(const char *msg)
+{
+	fprintf(stderr, "mura-load: %s\n", msg);
+	exit(1);
+}
+
+static void
+stop(int sig)
+{
+	(void)sig;
+	running = 0;
+}
+
+static int
+shm_file(size_t size)
+{
+	char name[64];
+	int fd;
+
+	snprintf(name, sizeof(name), "/mura-load-%ld-%p", (long)getpid(), (void *)&size);
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0)
+		return -1;
+	shm_unlink(name);
+	if (ftruncate(fd, (off_t)size) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void
+buffer_release(void *data, struct wl_buffer *wl)
+{
+	(void)wl;
+	((struct buffer *)data)->busy = false;
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+	.release = buffer_release,
+};
+
+static void
+buffer_free(struct buffer *b)
+{
+	if (!b->wl)
+		return;
+	wl_buffer_destroy(b->wl);
+	munmap(b->pixels, b->size);
+	memset(b, 0, sizeof(*b));
+}
+
+static bool
+buffer_alloc(struct window *w, struct buffer *b)
+{
+	struct wl_shm_pool *pool;
+	uint32_t stride = w->width * 4;
+	int fd;
+
+	b->size = (size_t)stride * w->height;
+	if ((fd = shm_file(b->size)) < 0)
+		return false;
+	b->pixels = mmap(NULL, b->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (b->pixels == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	pool = wl_shm_create_pool(w->client->shm, fd, (int32_t)b->size);
+	b->wl = wl_shm_pool_create_buffer(pool, 0, (int32_t)w->width, (int32_t)w->height,
+	                                  (int32_t)stride, WL_SHM_FORMAT_XRGB8888);
+	wl_shm_pool_destroy(pool);
+	close(fd);
+	wl_buffer_add_listener(b->wl, &buffer_listener, b);
+
+	/* a colour per window, so they can be told apart */
+	for (size_t i = 0; i < b->size / 4; i++)
+		b->pixels[i] = 0xff000000 | (w->index * 2654435761u >> 8);
+	return true;
+}
+
+static struct buffer *
+next_buffer(struct window *w)
+{
+	if (w->resized) {
+		buffer_free(&w->buffers[0]);
+		buffer_free(&w->buffers[1]);
+		w->resized = false;
+	}
+	for (int i = 0; i < 2; i++) {
+		struct buffer *b = &w->buffers[i];
+
+		if (!b->wl && !buffer_alloc(w, b))
+			return NULL;
+		if (!b->busy)
+			return b;
+	}
+	return NULL;
+}
+
+static void draw(struct window *w);
+
+static void
+frame_done(void *data, struct wl_callback *cb, uint32_t time)
+{
+	struct window *w = data;
+
+	(void)time;
+	wl_callback_destroy(cb);
+	w->frame = NULL;
+	hist_add(&w->latency, now_nsec() - w->committed_at);
+
+	/* unthrottled windows draw again as soon as they may */
+	if (opt.rate == 0 && running)
+		draw(w);
+}
+
+static const struct wl_callback_listener frame_listener = {
+	.done = frame_done,
+};
+
+static void
+draw(struct window *w)
+{
+	struct buffer *b;
+	uint32_t sq = 64, x, y, row;
+
+	if (!w->configured)
+		return;
+	if (w->frame) {
+		w->dropped++;
+		return;
+	}
+	if (!(b = next_buffer(w))) {
+		w->starved++;
+		return;
+	}
+
+	w->tick++;
+	switch (opt.damage) {
+	case DAMAGE_FULL:
+		for (size_t i = 0; i < b->size / 4; i++)
+			b->pixels[i] ^= 0x00202020;
+		wl_surface_damage_buffer(w->surface, 0, 0, (int32_t)w->width, (int32_t)w->height);
+		break;
+	case DAMAGE_RECT:
+		if (sq > w->width)
+			sq = w->width;
+		if (sq > w->height)
+			sq = w->height;
+		x = (w->tick * 8) % (w->width - sq + 1);
+		y = (w->tick * 5) % (w->height - sq + 1);
+		for (row = y; row < y + sq; row++) {
+			for (uint32_t col = x; col < x + sq; col++)
+				b->pixels[row * w->width + col] ^= 0x00ffffff;
+		}
+		wl_surface_damage_buffer(w->surface, (int32_t)x, (int32_t)y, (int32_t)sq, (int32_t)sq);
+		break;
+	case DAMAGE_NONE:
+		break;
+	}
+
+	w->frame = wl_surface_frame(w->surface);
+	wl_callback_add_listener(w->frame, &frame_listener, w);
+	wl_surface_attach(w->surface, b->wl, 0, 0);
+	b->busy = true;
+	wl_surface_commit(w->surface);
+	w->committed_at = now_nsec();
+	w->frames++;
+}
+
+static void
+xdg_surface_configure(void *data, struct xdg_surface *xdg_surface, uint32_t serial)
+{
+	struct window *w = data;
+	bool first = !w->configured;
+
+	xdg_surface_ack_configure(xdg_surface, serial);
+	w->configured = true;
+	if (first)
+		draw(w);
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+	.configure = xdg_surface_configure,
+};
+
+static void
+toplevel_configure(void *data, struct xdg_toplevel *toplevel, int32_t width, int32_t height,
+                   struct wl_array *states)
+{
+	struct window *w = data;
+
+	(void)toplevel;
+	(void)states;
+	if (width > 0 && height > 0 && ((uint32_t)width != w->width || (uint32_t)height != w->height)) {
+		w->width = (uint32_t)width;
+		w->height = (uint32_t)height;
+		w->resized = true;
+	}
+}
+
+static void
+toplevel_close(void *data, struct xdg_toplevel *toplevel)
+{
+	(void)data;
+	(void)toplevel;
+	running = 0;
+}
+
+static const struct xdg_toplevel_listener toplevel_listener = {
+	.configure = toplevel_configure,
+	.close = toplevel_close,
+};
+
+static void
+wm_base_ping(void *data, struct xdg_wm_base *wm_base, uint32_t serial)
+{
+	(void)data;
+	xdg_wm_base_pong(wm_base, serial);
+}
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+	.ping = wm_base_ping,
+};
+
+static void
+registry_global(void *data, struct wl_registry *registry,
+                uint32_t name, const char *interface, uint32_t version)
+{
+	struct client *c = data;
+
+	(void)version;
+	if (strcmp(interface, "wl_compositor") == 0) {
+		c->compositor = wl_registry_bind(registry, name, &wl_compositor_interface, 4);
+	} else if (strcmp(interface, "wl_shm") == 0) {
+		c->shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+	} else if (strcmp(interface, "xdg_wm_base") == 0) {
+		c->wm_base = wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+		xdg_wm_base_add_listener(c->wm_base, &wm_base_listener, c);
+	}
+}
+
+static void
+registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+	(void)data;
+	(void)registry;
+	(void)name;
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = registry_global,
+	.global_remove = registry_global_remove,
+};
+
+static void
+client_connect(struct client *c)
+{
+	if (!(c->display = wl_display_connect(NULL)))
+		die("cannot connect to the display");
+	c->registry = wl_display_get_registry(c->display);
+	wl_registry_add_listener(c->registry, &registry_listener, c);
+	wl_display_roundtrip(c->display);
+	if (!c->compositor || !c->shm || !c->wm_base)
+		die("missing wl_compositor, wl_shm or xdg_wm_base");
+}
+
+static void
+window_open(struct window *w, struct client *c, uint32_t index)
+{
+	char title[128], app_id[128];
+
+	w->client = c;
+	w->index = index;
+	w->width = opt.min_w + (opt.max_w > opt.min_w ? (index * 7919) % (opt.max_w - opt.min_w + 1) : 0);
+	w->height = opt.min_h + (opt.max_h > opt.min_h ? (index * 104729) % (opt.max_h - opt.min_h + 1) : 0);
+
+	w->surface = wl_compositor_create_surface(c->compositor);
+	w->xdg_surface = xdg_wm_base_get_xdg_surface(c->wm_base, w->surface);
+	xdg_surface_add_listener(w->xdg_surface, &xdg_surface_listener, w);
+	w->toplevel = xdg_surface_get_toplevel(w->xdg_surface);
+	xdg_toplevel_add_listener(w->toplevel, &toplevel_listener, w);
+
+	snprintf(app_id, sizeof(app_id), "%s", opt.app_id);
+	snprintf(title, sizeof(title), "%s %" PRIu32, opt.title, index);
+	xdg_toplevel_set_app_id(w->toplevel, app_id);
+	xdg_toplevel_set_title(w->toplevel, title);
+	wl_surface_commit(w->surface);
+}
+
+static void
+window_close(struct window *w)
+{
+	if (w->frame)
+		wl_callback_destroy(w->frame);
+	buffer_free(&w->buffers[0]);
+	buffer_free(&w->buffers[1]);
+	xdg_toplevel_destroy(w->toplevel);
+	xdg_surface_destroy(w->xdg_surface);
+	wl_surface_destroy(w->surface);
+}
+
+static bool
+parse_size(const char *s, uint32_t *w, uint32_t *h)
+{
+	unsigned a, b;
+	int n;
+
+	if (sscanf(s, "%ux%u%n", &a, &b, &n) != 2 || a == 0 || b == 0)
+		return false;
+	*w = a;
+	*h = b;
+	return s[n] == '\0' || s[n] == '-';
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: mura-load [-n windows] [-c clients] [-s WxH[-WxH]] [-r hz]\n"
+	                "                 [-d full|rect|none] [-a app_id] [-t title] [-T seconds] [-v]\n");
+	exit(1);
+}
+
+static void
+report(uint64_t elapsed)
+{
+	struct hist all;
+	uint64_t frames = 0, dropped = 0, starved = 0;
+	double secs = (double)elapsed / 1e9;
+	uint32_t i, worst = 0;
+
+	memset(&all, 0, sizeof(all));
+	for (i = 0; i < opt.windows; i++) {
+		struct window *w = &windows[i];
+
+		frames += w->frames;
+		dropped += w->dropped;
+		starved += w->starved;
+		all.count += w->latency.count;
+		all.total += w->latency.total;
+		if (w->latency.max > all.max)
+			all.max = w->latency.max;
+		for (uint32_t j = 0; j < HIST_BUCKETS; j++)
+			all.buckets[j] += w->latency.buckets[j];
+		if (hist_percentile(&w->latency, 99) > hist_percentile(&windows[worst].latency, 99))
+			worst = i;
+
+		if (opt.verbose)
+			printf("window %4" PRIu32 " %4" PRIu32 "x%-4" PRIu32 " %8.1f fps  p50 %7.2f ms  p99 %7.2f ms  dropped %" PRIu64 "\n",
+			       i, w->width, w->height, (double)w->frames / secs,
+			       hist_percentile(&w->latency, 50) / 1e6, hist_percentile(&w->latency, 99) / 1e6, w->dropped);
+	}
+
+	printf("%" PRIu32 " windows on %" PRIu32 " clients, %.1f s\n", opt.windows, opt.clients, secs);
+	printf("frames      %" PRIu64 " (%.1f fps per window)\n", frames, (double)frames / secs / opt.windows);
+	printf("dropped     %" PRIu64 " (frame callback still pending when the next frame was due)\n", dropped);
+	printf("starved     %" PRIu64 " (both buffers still held by the compositor)\n", starved);
+	printf("callback    p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  p99.9 %.2f ms  max %.2f ms\n",
+	       hist_percentile(&all, 50) / 1e6, hist_percentile(&all, 90) / 1e6,
+	       hist_percentile(&all, 99) / 1e6, hist_percentile(&all, 99.9) / 1e6, all.max / 1e6);
+	printf("worst p99   window %" PRIu32 ", %.2f ms\n", worst, hist_percentile(&windows[worst].latency, 99) / 1e6);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct pollfd *fds;
+	uint64_t start, now, period, deadline, next;
+	const char *dash;
+	uint32_t i;
+	int c, timeout;
+
+	while ((c = getopt(argc, argv, "n:c:s:r:d:a:t:T:v")) != -1) {
+		switch (c) {
+		case 'n':
+			opt.windows = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'c':
+			opt.clients = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			if (!parse_size(optarg, &opt.min_w, &opt.min_h))
+				usage();
+			opt.max_w = opt.min_w;
+			opt.max_h = opt.min_h;
+			if ((dash = strchr(optarg, '-')) && !parse_size(dash + 1, &opt.max_w, &opt.max_h))
+				usage();
+			if (opt.max_w < opt.min_w || opt.max_h < opt.min_h)
+				usage();
+			break;
+		case 'r':
+			opt.rate = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			if (strcmp(optarg, "full") == 0)
+				opt.damage = DAMAGE_FULL;
+			else if (strcmp(optarg, "rect") == 0)
+				opt.damage = DAMAGE_RECT;
+			else if (strcmp(optarg, "none") == 0)
+				opt.damage = DAMAGE_NONE;
+			else
+				usage();
+			break;
+		case 'a':
+			opt.app_id = optarg;
+			break;
+		case 't':
+			opt.title = optarg;
+			break;
+		case 'T':
+			opt.seconds = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'v':
+			opt.verbose = true;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc || opt.windows == 0)
+		usage();
+	/* a connection per window unless told otherwise */
+	if (opt.clients == 0 || opt.clients > opt.windows)
+		opt.clients = opt.windows;
+
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+
+	clients = calloc(opt.clients, sizeof(*clients));
+	windows = calloc(opt.windows, sizeof(*windows));
+	fds = calloc(opt.clients, sizeof(*fds));
+	if (!clients || !windows || !fds)
+		die("out of memory");
+
+	for (i = 0; i < opt.clients; i++)
+		client_connect(&clients[i]);
+	for (i = 0; i < opt.windows; i++)
+		window_open(&windows[i], &clients[i % opt.clients], i);
+
+	start = now_nsec();
+	deadline = opt.seconds ? start + (uint64_t)opt.seconds * 1000000000 : 0;
+	period = opt.rate ? 1000000000 / opt.rate : 0;
+	for (i = 0; i < opt.windows; i++)
+		windows[i].next_due = start + (period ? period * i / opt.windows : 0);
+
+	while (running) {
+		now = now_nsec();
+		if (deadline && now >= deadline)
+			break;
+
+		/* rate limited windows: draw the ones that are due */
+		next = deadline ? deadline : now + 1000000000;
+		if (period) {
+			for (i = 0; i < opt.windows; i++) {
+				struct window *w = &windows[i];
+
+				if (now >= w->next_due) {
+					draw(w);
+					w->next_due += period;
+					if (w->next_due <= now)
+						w->next_due = now + period;
+				}
+				if (w->next_due < next)
+					next = w->next_due;
+			}
+		}
+
+		for (i = 0; i < opt.clients; i++) {
+			while (wl_display_prepare_read(clients[i].display) != 0)
+				wl_display_dispatch_pending(clients[i].display);
+			wl_display_flush(clients[i].display);
+			fds[i].fd = wl_display_get_fd(clients[i].display);
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+
+		timeout = next > now ? (int)((next - now + 999999) / 1000000) : 0;
+		if (poll(fds, opt.clients, timeout) < 0 && errno != EINTR)
+			die("poll failed");
+
+		for (i = 0; i < opt.clients; i++) {
+			if (fds[i].revents & POLLIN) {
+				if (wl_display_read_events(clients[i].display) < 0)
+					die("lost the display");
+			} else {
+				wl_display_cancel_read(clients[i].display);
+			}
+			if (fds[i].revents & (POLLERR | POLLHUP))
+				die("lost the display");
+			wl_display_dispatch_pending(clients[i].display);
+		}
+	}
+
+	report(now_nsec() - start);
+
+	for (i = 0; i < opt.windows; i++)
+		window_close(&windows[i]);
+	for (i = 0; i < opt.clients; i++) {
+		wl_display_flush(clients[i].display);
+		wl_display_disconnect(clients[i].display);
+	}
+	free(fds);
+	free(windows);
+	free(clients);
+	return 0;
+}
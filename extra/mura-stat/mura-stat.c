@@ -0,0 +1,278 @@
+/* mura-stat: print the latency histograms mura keeps for its handlers.
+ *
+ * usage: mura-stat [-a] [-r] [-o file] [-c file]
+ *   -a       also list handlers that never ran
+ *   -r       clear the histograms after reading them
+ *   -o file  save the snapshot, to compare a later one against
+ *   -c file  show how each percentile moved since a saved snapshot
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include "mura-client-protocol.h"
+#include "../../hist.h"
+
+struct entry {
+	char name[64];
+	uint32_t mean;
+	struct hist hist;
+};
+
+/* what a row shows, in ns */
+struct row {
+	char name[64];
+	uint64_t count, mean, p50, p90, p99, p999, max;
+};
+
+static struct mura_stat *stats;
+static struct entry *entries;
+static size_t nentries;
+static bool done;
+
+static void
+die(const char *msg)
+{
+	fprintf(stderr, "mura-stat: %s\n", msg);
+	exit(1);
+}
+
+static void
+stat_histogram(void *data, struct mura_stat *s, const char *name,
+               uint32_t count, uint32_t mean_ns, uint32_t max_ns)
+{
+	struct entry *e;
+
+	(void)data;
+	(void)s;
+
+	e = realloc(entries, (nentries + 1) * sizeof(*e));
+	if (!e)
+		die("out of memory");
+	entries = e;
+	e = &entries[nentries++];
+	memset(e, 0, sizeof(*e));
+	snprintf(e->name, sizeof(e->name), "%s", name);
+	e->mean = mean_ns;
+	e->hist.count = count;
+	e->hist.max = max_ns;
+}
+
+static void
+stat_buckets(void *data, struct mura_stat *s, struct wl_array *buckets)
+{
+	uint32_t *pair;
+	struct entry *e;
+
+	(void)data;
+	(void)s;
+
+	if (nentries == 0)
+		return;
+	e = &entries[nentries - 1];
+	for (pair = buckets->data; (char *)(pair + 2) <= (char *)buckets->data + buckets->size; pair += 2) {
+		if (pair[0] < HIST_BUCKETS)
+			e->hist.buckets[pair[0]] = pair[1];
+	}
+}
+
+static void
+stat_done(void *data, struct mura_stat *s)
+{
+	(void)data;
+	(void)s;
+	done = true;
+}
+
+static const struct mura_stat_listener stat_listener = {
+	.histogram = stat_histogram,
+	.buckets = stat_buckets,
+	.done = stat_done,
+};
+
+static void
+registry_global(void *data, struct wl_registry *registry,
+                uint32_t name, const char *interface, uint32_t version)
+{
+	(void)data;
+	(void)version;
+
+	if (strcmp(interface, "mura_stat") == 0) {
+		stats = wl_registry_bind(registry, name, &mura_stat_interface, 1);
+		mura_stat_add_listener(stats, &stat_listener, NULL);
+	}
+}
+
+static void
+registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+	(void)data;
+	(void)registry;
+	(void)name;
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = registry_global,
+	.global_remove = registry_global_remove,
+};
+
+static struct row
+row_of(const struct entry *e)
+{
+	struct row r;
+
+	snprintf(r.name, sizeof(r.name), "%s", e->name);
+	r.count = e->hist.count;
+	r.mean = e->mean;
+	r.p50 = hist_percentile(&e->hist, 50);
+	r.p90 = hist_percentile(&e->hist, 90);
+	r.p99 = hist_percentile(&e->hist, 99);
+	r.p999 = hist_percentile(&e->hist, 99.9);
+	r.max = e->hist.max;
+	return r;
+}
+
+/* saved snapshots are one row per line, all values in ns */
+static struct row *
+load_rows(const char *path, size_t *n)
+{
+	struct row *rows = NULL, r, *tmp;
+	char line[256];
+	FILE *f;
+
+	*n = 0;
+	if (!(f = fopen(path, "r")))
+		die("cannot open the snapshot to compare against");
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%63s %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+		           r.name, &r.count, &r.mean, &r.p50, &r.p90, &r.p99, &r.p999, &r.max) != 8)
+			continue;
+		if (!(tmp = realloc(rows, (*n + 1) * sizeof(*rows))))
+			die("out of memory");
+		rows = tmp;
+		rows[(*n)++] = r;
+	}
+	fclose(f);
+	return rows;
+}
+
+static const struct row *
+find_row(const struct row *rows, size_t n, const char *name)
+{
+	for (size_t i = 0; i < n; i++) {
+		if (strcmp(rows[i].name, name) == 0)
+			return &rows[i];
+	}
+	return NULL;
+}
+
+static void
+put_us(uint64_t ns)
+{
+	printf(" %9.1f", (double)ns / 1000.0);
+}
+
+static void
+put_change(uint64_t now, uint64_t then)
+{
+	if (then == 0)
+		printf(" %7s", "-");
+	else
+		printf(" %+6.0f%%", ((double)now - (double)then) * 100.0 / (double)then);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *save = NULL, *compare = NULL;
+	struct wl_display *display;
+	struct wl_registry *registry;
+	struct row *old = NULL;
+	size_t nold = 0;
+	bool all = false, reset = false;
+	FILE *out = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "aro:c:")) != -1) {
+		switch (c) {
+		case 'a':
+			all = true;
+			break;
+		case 'r':
+			reset = true;
+			break;
+		case 'o':
+			save = optarg;
+			break;
+		case 'c':
+			compare = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: mura-stat [-a] [-r] [-o file] [-c file]\n");
+			return 1;
+		}
+	}
+
+	if (compare)
+		old = load_rows(compare, &nold);
+	if (save && !(out = fopen(save, "w")))
+		die("cannot write the snapshot");
+
+	if (!(display = wl_display_connect(NULL)))
+		die("cannot connect to the display");
+	registry = wl_display_get_registry(display);
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+	if (!stats)
+		die("the compositor has no mura_stat");
+
+	mura_stat_snapshot(stats, reset);
+	while (!done && wl_display_dispatch(display) != -1)
+		;
+	if (!done)
+		die("lost the display before the snapshot was done");
+
+	printf("%-32s %10s %9s %9s %9s %9s %9s %9s", "handler (us)", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+	if (old)
+		printf(" %7s %7s", "p50", "p99");
+	printf("\n");
+
+	for (size_t i = 0; i < nentries; i++) {
+		struct row r = row_of(&entries[i]);
+		const struct row *then = old ? find_row(old, nold, r.name) : NULL;
+
+		if (out)
+			fprintf(out, "%s %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+			        r.name, r.count, r.mean, r.p50, r.p90, r.p99, r.p999, r.max);
+		if (r.count == 0 && !all)
+			continue;
+
+		printf("%-32s %10" PRIu64, r.name, r.count);
+		put_us(r.mean);
+		put_us(r.p50);
+		put_us(r.p90);
+		put_us(r.p99);
+		put_us(r.p999);
+		put_us(r.max);
+		if (old) {
+			put_change(r.p50, then ? then->p50 : 0);
+			put_change(r.p99, then ? then->p99 : 0);
+		}
+		printf("\n");
+	}
+
+	if (out)
+		fclose(out);
+	mura_stat_destroy(stats);
+	wl_display_roundtrip(display);
+	wl_display_disconnect(display);
+	free(entries);
+	free(old);
+	return 0;
+}
@@ -0,0 +1,343 @@
+/* mura-top: which window's client is keeping mura busy.
+ *
+ * usage: mura-top [-s key] [-i ms] [-n count] [-j id]
+ *   -s key    sort by commits, damage, frames, memory, pid, app or title
+ *   -i ms     time between samples, 1000 by default
+ *   -n count  samples to print, 0 (the default) to keep going
+ *   -j id     jump to window id and exit
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include "mura-client-protocol.h"
+
+#define FORMAT_GPU 0xffffffffu
+
+struct sample {
+	uint32_t id;
+	int32_t pid;
+	char app_id[32], title[64];
+	uint32_t commits, frames, pending, damage_kpx;
+	uint32_t width, height, format, memory_kb;
+};
+
+/* a window's rates over the last interval */
+struct row {
+	const struct sample *s;
+	double commits, frames, damage_mpx;
+};
+
+enum sort_key {
+	SORT_COMMITS,
+	SORT_DAMAGE,
+	SORT_FRAMES,
+	SORT_MEMORY,
+	SORT_PID,
+	SORT_APP,
+	SORT_TITLE,
+};
+
+static const char *const sort_names[] = {
+	[SORT_COMMITS] = "commits",
+	[SORT_DAMAGE]  = "damage",
+	[SORT_FRAMES]  = "frames",
+	[SORT_MEMORY]  = "memory",
+	[SORT_PID]     = "pid",
+	[SORT_APP]     = "app",
+	[SORT_TITLE]   = "title",
+};
+
+static struct mura_top *top;
+static struct sample *samples;
+static size_t nsamples, cap;
+static bool done;
+static enum sort_key sort_key = SORT_COMMITS;
+
+static void
+die(const char *msg)
+{
+	fprintf(stderr, "mura-top: %s\n", msg);
+	exit(1);
+}
+
+static void
+top_window(void *data, struct mura_top *t, uint32_t id, int32_t pid,
+           const char *app_id, const char *title, uint32_t commits, uint32_t frames,
+           uint32_t frames_pending, uint32_t damage_kpx, uint32_t width, uint32_t height,
+           uint32_t format, uint32_t memory_kb)
+{
+	struct sample *s;
+
+	(void)data;
+	(void)t;
+
+	if (nsamples == cap) {
+		cap = cap ? cap * 2 : 64;
+		if (!(s = realloc(samples, cap * sizeof(*s))))
+			die("out of memory");
+		samples = s;
+	}
+	s = &samples[nsamples++];
+	s->id = id;
+	s->pid = pid;
+	snprintf(s->app_id, sizeof(s->app_id), "%s", app_id ? app_id : "");
+	snprintf(s->title, sizeof(s->title), "%s", title ? title : "");
+	s->commits = commits;
+	s->frames = frames;
+	s->pending = frames_pending;
+	s->damage_kpx = damage_kpx;
+	s->width = width;
+	s->height = height;
+	s->format = format;
+	s->memory_kb = memory_kb;
+}
+
+static void
+top_done(void *data, struct mura_top *t)
+{
+	(void)data;
+	(void)t;
+	done = true;
+}
+
+static const struct mura_top_listener top_listener = {
+	.window = top_window,
+	.done = top_done,
+};
+
+static void
+registry_global(void *data, struct wl_registry *registry,
+                uint32_t name, const char *interface, uint32_t version)
+{
+	(void)data;
+	(void)version;
+
+	if (strcmp(interface, "mura_top") == 0) {
+		top = wl_registry_bind(registry, name, &mura_top_interface, 1);
+		mura_top_add_listener(top, &top_listener, NULL);
+	}
+}
+
+static void
+registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+	(void)data;
+	(void)registry;
+	(void)name;
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = registry_global,
+	.global_remove = registry_global_remove,
+};
+
+static double
+now_sec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void
+snapshot(struct wl_display *display)
+{
+	nsamples = 0;
+	done = false;
+	mura_top_snapshot(top);
+	while (!done && wl_display_dispatch(display) != -1)
+		;
+	if (!done)
+		die("lost the display");
+}
+
+static const struct sample *
+find_sample(const struct sample *list, size_t n, uint32_t id)
+{
+	for (size_t i = 0; i < n; i++) {
+		if (list[i].id == id)
+			return &list[i];
+	}
+	return NULL;
+}
+
+static int
+compare_rows(const void *a, const void *b)
+{
+	const struct row *x = a, *y = b;
+	double d = 0;
+
+	switch (sort_key) {
+	case SORT_COMMITS:
+		d = y->commits - x->commits;
+		break;
+	case SORT_DAMAGE:
+		d = y->damage_mpx - x->damage_mpx;
+		break;
+	case SORT_FRAMES:
+		d = y->frames - x->frames;
+		break;
+	case SORT_MEMORY:
+		d = (double)y->s->memory_kb - (double)x->s->memory_kb;
+		break;
+	case SORT_PID:
+		d = (double)x->s->pid - (double)y->s->pid;
+		break;
+	case SORT_APP:
+		return strcmp(x->s->app_id, y->s->app_id);
+	case SORT_TITLE:
+		return strcmp(x->s->title, y->s->title);
+	}
+	return d < 0 ? -1 : d > 0;
+}
+
+static const char *
+format_name(uint32_t format, char buf[5])
+{
+	if (format == FORMAT_GPU)
+		return "gpu";
+	/* wl_shm's two formats that are not fourcc codes */
+	if (format == 0)
+		return "ARGB";
+	if (format == 1)
+		return "XRGB";
+	for (int i = 0; i < 4; i++) {
+		char c = (char)(format >> (8 * i));
+		buf[i] = c >= ' ' && c <= '~' ? c : '?';
+	}
+	buf[4] = '\0';
+	return buf;
+}
+
+static void
+print_rows(const struct sample *old, size_t nold, double secs, bool clear)
+{
+	struct row *rows;
+	char size[24], fourcc[5];
+
+	if (!(rows = calloc(nsamples ? nsamples : 1, sizeof(*rows))))
+		die("out of memory");
+	for (size_t i = 0; i < nsamples; i++) {
+		const struct sample *s = &samples[i];
+		const struct sample *then = find_sample(old, nold, s->id);
+
+		rows[i].s = s;
+		/* counters wrap, unsigned differences do not care */
+		if (then && secs > 0) {
+			rows[i].commits = (uint32_t)(s->commits - then->commits) / secs;
+			rows[i].frames = (uint32_t)(s->frames - then->frames) / secs;
+			rows[i].damage_mpx = (uint32_t)(s->damage_kpx - then->damage_kpx) / secs / 1000.0;
+		}
+	}
+	qsort(rows, nsamples, sizeof(*rows), compare_rows);
+
+	if (clear)
+		printf("\033[H\033[2J");
+	printf("%6s %7s %8s %8s %8s %4s %11s %4s %8s  %-16s %s\n", "id", "pid", "commit/s",
+	       "frame/s", "Mpx/s", "pend", "size", "fmt", "mem KiB", "app_id", "title");
+	for (size_t i = 0; i < nsamples; i++) {
+		const struct sample *s = rows[i].s;
+
+		snprintf(size, sizeof(size), "%ux%u", s->width, s->height);
+		printf("%6u %7d %8.1f %8.1f %8.2f %4u %11s %4s %8u  %-16.16s %.40s\n", s->id, (int)s->pid,
+		       rows[i].commits, rows[i].frames, rows[i].damage_mpx, s->pending,
+		       s->width ? size : "-", s->commits ? format_name(s->format, fourcc) : "-",
+		       s->memory_kb, s->app_id, s->title);
+	}
+	printf("\n");
+	fflush(stdout);
+	free(rows);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct wl_display *display;
+	struct wl_registry *registry;
+	struct sample *old = NULL, *tmp;
+	size_t nold = 0, old_cap = 0, n;
+	long interval = 1000, count = 0, jump = -1;
+	bool clear = isatty(STDOUT_FILENO);
+	double then, now;
+	int c;
+
+	while ((c = getopt(argc, argv, "s:i:n:j:")) != -1) {
+		switch (c) {
+		case 's':
+			for (n = 0; n < sizeof(sort_names) / sizeof(sort_names[0]); n++) {
+				if (strcasecmp(optarg, sort_names[n]) == 0)
+					break;
+			}
+			if (n == sizeof(sort_names) / sizeof(sort_names[0]))
+				die("sort by commits, damage, frames, memory, pid, app or title");
+			sort_key = (enum sort_key)n;
+			break;
+		case 'i':
+			interval = strtol(optarg, NULL, 10);
+			break;
+		case 'n':
+			count = strtol(optarg, NULL, 10);
+			break;
+		case 'j':
+			jump = strtol(optarg, NULL, 10);
+			break;
+		default:
+			fprintf(stderr, "usage: mura-top [-s key] [-i ms] [-n count] [-j id]\n");
+			return 1;
+		}
+	}
+	if (interval <= 0)
+		die("the interval has to be positive");
+
+	if (!(display = wl_display_connect(NULL)))
+		die("cannot connect to the display");
+	registry = wl_display_get_registry(display);
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+	if (!top)
+		die("the compositor has no mura_top");
+
+	if (jump >= 0) {
+		mura_top_focus(top, (uint32_t)jump);
+		wl_display_roundtrip(display);
+		goto out;
+	}
+
+	snapshot(display);
+	then = now_sec();
+	for (long i = 0; count == 0 || i < count; i++) {
+		struct timespec ts = { interval / 1000, (interval % 1000) * 1000000 };
+
+		/* keep the last sample to diff against, reuse the one before */
+		tmp = old;
+		old = samples;
+		samples = tmp;
+		nold = nsamples;
+		n = old_cap;
+		old_cap = cap;
+		cap = n;
+
+		nanosleep(&ts, NULL);
+		snapshot(display);
+		now = now_sec();
+		print_rows(old, nold, now - then, clear);
+		then = now;
+	}
+
+out:
+	mura_top_destroy(top);
+	wl_display_roundtrip(display);
+	wl_display_disconnect(display);
+	free(samples);
+	free(old);
+	return 0;
+}
@@ -0,0 +1,201 @@
+/* mura-trace: dump the trace ring of mura -t as Chrome trace JSON, which
+ * ui.perfetto.dev and chrome://tracing both open.
+ *
+ * usage: mura-trace ring > trace.json
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../../trace.h"
+
+/* tracks in the timeline */
+enum {
+	TID_HANDLERS = 1,
+	TID_INPUT,
+	TID_WINDOWS,
+	TID_SCROLL,
+	TID_SLOW,
+};
+
+static const char *
+string_at(const struct trace_header *h, uint32_t nstrings, uint16_t i)
+{
+	return i < nstrings ? h->strings[i] : "?";
+}
+
+/* names come from mura's own literals, but stay safe for JSON anyway */
+static void
+put_name(const char *s)
+{
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			putchar('\\');
+		if ((unsigned char)*s >= 0x20)
+			putchar(*s);
+	}
+	putchar('"');
+}
+
+static void
+put_event(const struct trace_record *r, const char *name, uint64_t base, int *first)
+{
+	double ts = (double)(r->ts - base) / 1000.0;
+
+	printf("%s\n{", *first ? "" : ",");
+	*first = 0;
+
+	switch (r->type) {
+	case TRACE_SPAN:
+		printf("\"ph\":\"X\",\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+		       TID_HANDLERS, ts, r->dur / 1000.0);
+		put_name(name);
+		break;
+	case TRACE_MARK:
+		printf("\"ph\":\"i\",\"s\":\"t\",\"tid\":%d,\"ts\":%.3f,\"name\":", TID_SCROLL, ts);
+		put_name(name);
+		printf(",\"args\":{\"a\":%d,\"b\":%d}", r->a, r->b);
+		break;
+	case TRACE_FOCUS:
+		printf("\"ph\":\"i\",\"s\":\"t\",\"tid\":%d,\"ts\":%.3f,\"name\":\"focus\","
+		       "\"args\":{\"reason\":", TID_WINDOWS, ts);
+		put_name(name);
+		printf(",\"from\":\"%08x\",\"to\":\"%08x\"}", (unsigned)r->a, (unsigned)r->b);
+		break;
+	case TRACE_BUTTON:
+		printf("\"ph\":\"i\",\"s\":\"t\",\"tid\":%d,\"ts\":%.3f,\"name\":\"button %s %s\","
+		       "\"args\":{\"code\":%d}", TID_INPUT, ts, name, r->b ? "pressed" : "released", r->a);
+		break;
+	case TRACE_WINDOW:
+		printf("\"ph\":\"i\",\"s\":\"t\",\"tid\":%d,\"ts\":%.3f,\"name\":\"window\","
+		       "\"args\":{\"window\":\"%08x\",\"pid\":%d}", TID_WINDOWS, ts, (unsigned)r->a, r->b);
+		break;
+	case TRACE_SCREEN:
+		printf("\"ph\":\"i\",\"s\":\"g\",\"tid\":%d,\"ts\":%.3f,\"name\":\"screen %dx%d\"",
+		       TID_WINDOWS, ts, r->a, r->b);
+		break;
+	case TRACE_SPAWN:
+		printf("\"ph\":\"i\",\"s\":\"t\",\"tid\":%d,\"ts\":%.3f,\"name\":\"spawn %dx%d\"",
+		       TID_WINDOWS, ts, r->a, r->b);
+		break;
+	case TRACE_SCROLL:
+		printf("\"ph\":\"C\",\"tid\":%d,\"ts\":%.3f,\"name\":", TID_SCROLL, ts);
+		put_name(name);
+		printf(",\"args\":{\"pending\":%d,\"step\":%d}", r->a, r->b);
+		break;
+	case TRACE_SLOW:
+		printf("\"ph\":\"X\",\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+		       TID_SLOW, ts, r->dur / 1000.0);
+		put_name(name);
+		if (r->a)
+			printf(",\"args\":{\"client\":%d}", r->a);
+		break;
+	default:
+		printf("\"ph\":\"i\",\"s\":\"t\",\"tid\":%d,\"ts\":%.3f,\"name\":\"type %u\"",
+		       TID_HANDLERS, ts, (unsigned)r->type);
+		break;
+	}
+	printf(",\"pid\":1}");
+}
+
+static void
+put_thread_name(int tid, const char *name)
+{
+	printf(",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+	       "\"args\":{\"name\":\"%s\"}}", tid, name);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct trace_header *h;
+	const struct trace_record *ring;
+	struct trace_record *copy;
+	struct stat st;
+	uint64_t head, end, first_index, i, base;
+	uint32_t nstrings, cap;
+	int fd, first = 1;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: mura-trace ring > trace.json\n");
+		return 1;
+	}
+
+	fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+	if ((size_t)st.st_size < sizeof(*h)) {
+		fprintf(stderr, "%s: not a mura trace ring\n", argv[1]);
+		return 1;
+	}
+	h = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (h == MAP_FAILED) {
+		fprintf(stderr, "cannot map %s\n", argv[1]);
+		return 1;
+	}
+
+	if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != TRACE_MAGIC ||
+	    h->version != TRACE_VERSION || h->record_size != sizeof(struct trace_record) ||
+	    h->capacity == 0 || (h->capacity & (h->capacity - 1)) ||
+	    (size_t)st.st_size < sizeof(*h) + (size_t)h->capacity * sizeof(struct trace_record)) {
+		fprintf(stderr, "%s: not a mura trace ring\n", argv[1]);
+		return 1;
+	}
+	cap = h->capacity;
+	ring = (const struct trace_record *)(h + 1);
+
+	/* copy out what is there, then drop whatever mura overwrote meanwhile.
+	 * mura writes record end into the slot of end - cap before it moves
+	 * head past it, so that one may be torn as well */
+	copy = malloc((size_t)cap * sizeof(*copy));
+	if (!copy) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	head = __atomic_load_n(&h->head, __ATOMIC_ACQUIRE);
+	first_index = head > cap ? head - cap : 0;
+	for (i = first_index; i < head; i++)
+		copy[i & (cap - 1)] = ring[i & (cap - 1)];
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	end = __atomic_load_n(&h->head, __ATOMIC_ACQUIRE);
+	if (end >= cap && end - cap + 1 > first_index)
+		first_index = end - cap + 1;
+	if (first_index > head)
+		first_index = head;
+	nstrings = __atomic_load_n(&h->nstrings, __ATOMIC_ACQUIRE);
+	if (nstrings > TRACE_STRINGS)
+		nstrings = TRACE_STRINGS;
+
+	base = first_index < head ? copy[first_index & (cap - 1)].ts : 0;
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (i = first_index; i < head; i++) {
+		const struct trace_record *r = &copy[i & (cap - 1)];
+
+		put_event(r, string_at(h, nstrings, r->name), base, &first);
+	}
+	printf("%s\n{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"mura\"}}",
+	       first ? "" : ",");
+	put_thread_name(TID_HANDLERS, "handlers");
+	put_thread_name(TID_INPUT, "input");
+	put_thread_name(TID_WINDOWS, "windows");
+	put_thread_name(TID_SCROLL, "scroll");
+	put_thread_name(TID_SLOW, "slow");
+	printf("\n]}\n");
+
+	fprintf(stderr, "%" PRIu64 " records, %" PRIu64 " lost to the ring wrapping\n",
+	        head - first_index, first_index);
+	free(copy);
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include "hist.h"
+
+uint32_t
+hist_index(uint64_t v)
+{
+	uint32_t msb, shift;
+
+	if (v < 2 * HIST_SUB)
+		return (uint32_t)v;
+	if (v >> HIST_MAX_BITS)
+		return HIST_BUCKETS - 1;
+
+	msb = 63 - (uint32_t)__builtin_clzll(v);
+	shift = msb - HIST_SUB_BITS;
+	return 2 * HIST_SUB + (shift - 1) * HIST_SUB + (uint32_t)(v >> shift) - HIST_SUB;
+}
+
+uint64_t
+hist_value(uint32_t i)
+{
+	uint32_t shift;
+	uint64_t top;
+
+	if (i < 2 * HIST_SUB)
+		return i;
+	i -= 2 * HIST_SUB;
+	shift = i / HIST_SUB + 1;
+	top = i % HIST_SUB + HIST_SUB;
+	return ((top + 1) << shift) - 1;
+}
+
+void
+hist_add(struct hist *h, uint64_t v)
+{
+	h->count++;
+	h->total += v;
+	if (v > h->max)
+		h->max = v;
+	h->buckets[hist_index(v)]++;
+}
+
+uint64_t
+hist_percentile(const struct hist *h, double p)
+{
+	uint64_t want, seen = 0;
+	uint32_t i;
+
+	if (h->count == 0)
+		return 0;
+	want = (uint64_t)(p / 100.0 * (double)h->count + 0.5);
+	if (want == 0)
+		want = 1;
+
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= want)
+			return hist_value(i) < h->max ? hist_value(i) : h->max;
+	}
+	return h->max;
+}
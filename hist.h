@@ -0,0 +1,33 @@
+/* hist: log-linear latency histograms in the style of HdrHistogram.
+ *
+ * values below 32 get a bucket each, above that every power of two is split
+ * into 16 buckets, so a bucket is never wider than 1/16 of its values.
+ * nanoseconds up to about 18 minutes fit.
+ */
+#ifndef HIST_H
+#define HIST_H
+
+#include <stdint.h>
+
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1u << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS (2 * HIST_SUB + (HIST_MAX_BITS - HIST_SUB_BITS - 1) * HIST_SUB)
+
+struct hist {
+	uint64_t count;
+	uint64_t total, max;
+	uint64_t buckets[HIST_BUCKETS];
+};
+
+uint32_t hist_index(uint64_t v);
+
+/* the highest value that lands in bucket i */
+uint64_t hist_value(uint32_t i);
+
+void hist_add(struct hist *h, uint64_t v);
+
+/* smallest value that at least p percent of the samples are at or below */
+uint64_t hist_percentile(const struct hist *h, double p);
+
+#endif
@@ -1,16 +1,38 @@
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <signal.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <inttypes.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
 #include <wayland-server.h>
+#include <libinput.h>
+#include <libudev.h>
 
 #ifdef __linux__
 #include <linux/input-event-codes.h>
+#include <linux/memfd.h>
+/* glibc only has the seals with _GNU_SOURCE */
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS         1033
+#define F_SEAL_SHRINK       0x0002
+#define F_SEAL_GROW         0x0004
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+/* nor accept4 */
+int accept4(int fd, struct sockaddr *addr, socklen_t *len, int flags);
 /* define os-agnostic input codes for non-linux systems */
 #else
 #define BTN_LEFT    0x110
@@ -23,6 +45,10 @@
 
 #include "config.h"
 #include "nein_cursor.h"
+#include "spawner.h"
+#include "trace.h"
+#include "hist.h"
+#include "camera.h"
 
 #include "protocol/mura-server-protocol.h"
 
@@ -32,6 +58,8 @@ struct window {
 
 	/* term spawn prims */
 	pid_t pid;
+	struct wl_list pid_link;
+	bool swallow_pending, token_pending;
 	struct window *spawn_parent;
 	struct wl_list spawn_children;
 	struct wl_list spawn_link;
@@ -39,6 +67,96 @@ struct window {
 	struct swc_rectangle saved_geometry;
 
 	bool sticky;
+	bool pooled;
+
+	/* spawned at its selected size, hidden until a buffer of that size arrives */
+	bool map_pending;
+	uint32_t map_width, map_height;
+	uint64_t map_start, spawn_start;
+
+	uint32_t id; /* for mura-top, never reused */
+	struct surface_stat *stat;
+
+	/* mura_windows: what changed since the last frame, and what was sent */
+	struct wl_list dirty_link;
+	uint8_t dirty;
+	bool listed, sent_visible;
+	int64_t sent_x, sent_y;
+	uint32_t sent_width, sent_height;
+};
+
+enum wlist_bits {
+	WLIST_GEOMETRY = 1 << 0,
+	WLIST_TITLE    = 1 << 1,
+	WLIST_APP_ID   = 1 << 2,
+	WLIST_VISIBLE  = 1 << 3,
+	WLIST_ALL      = 0xf,
+};
+
+#define TELE_FRAMES 8        /* frame callbacks watched per surface */
+#define TELE_BUFFERS 4       /* buffers remembered per surface */
+#define TELE_FORMAT_GPU 0xffffffffu
+
+/* the requests window telemetry looks at, worked out once per message */
+enum tele_kind {
+	TELE_NONE,
+	TELE_ATTACH,
+	TELE_DAMAGE,
+	TELE_FRAME,
+	TELE_COMMIT,
+	TELE_XDG_SURFACE,
+	TELE_TOPLEVEL,
+	TELE_ACK_CONFIGURE,
+};
+
+struct frame_watch {
+	struct wl_listener destroy;
+	struct surface_stat *surface; /* NULL while the slot is free */
+};
+
+/* what a wl_surface has been doing, seen through the protocol logger. the
+ * counters only grow, mura-top turns them into rates */
+struct surface_stat {
+	struct wl_resource *surface;
+	struct wl_listener destroy;
+	struct wl_list link;
+	struct window *window;
+	uint32_t xdg_id; /* the xdg_surface made for it, 0 before that */
+	uint32_t commits, frames;
+	uint64_t damage, damage_pending; /* px */
+	uint32_t width, height, format, bytes; /* of the last buffer attached */
+	const void *buffers[TELE_BUFFERS]; /* compared, never dereferenced */
+	unsigned next_buffer;
+	struct frame_watch watches[TELE_FRAMES];
+};
+
+/* a process mura has seen as an ancestor of a window. entries drop out
+ * when the process exits, so a reused pid never finds a stale parent */
+struct proc {
+	pid_t pid, ppid;
+	int pidfd;
+	uint64_t stamp;
+	struct wl_event_source *source;
+	struct wl_list link;
+};
+
+#define PID_BUCKETS 256
+
+/* a child on its way up. selections wait for their terminal's window to
+ * place it, pool terminals keep theirs hidden until a selection takes it */
+enum spawn_kind {
+	SPAWN_FOR_SELECT,
+	SPAWN_FOR_POOL,
+};
+
+struct spawn_entry {
+	uint32_t token;
+	pid_t pid;
+	enum spawn_kind kind;
+	struct swc_rectangle geometry;
+	struct window *window;
+	uint64_t start;
+	struct wl_list link;
 };
 
 struct screen {
@@ -46,20 +164,115 @@ struct screen {
 	struct wl_list link;
 };
 
+struct gesture_device {
+	struct libinput_device *dev;
+	char *syspath;
+	struct wl_list link;
+};
+
 static const int timerms = 16;
 
 static const int scrollpx = 64;
 static const int scrollease = 4;
 static const int scrollcap = 64;
 
-static int scrollpos = 0;
-static struct wl_list scrollpos_resources;
+static volatile sig_atomic_t running = 1;
+
+/* input traces: a header followed by fixed-size records in host byte order.
+ * motion records carry the raw cursor position, button and axis records the
+ * arguments their binding received. */
+#define INPUT_TRACE_MAGIC   0x4152554d /* "MURA" */
+#define INPUT_TRACE_VERSION 1
+
+enum input_type {
+	INPUT_MOTION = 1,
+	INPUT_BUTTON,
+	INPUT_AXIS,
+};
+
+struct input_trace_header {
+	uint32_t magic;
+	uint32_t version;
+};
+
+struct input_event {
+	uint32_t msec;  /* since the start of the recording */
+	uint16_t type;
+	uint16_t code;  /* button or axis */
+	int32_t a, b;   /* x, y / state / value120 */
+};
+
+/* timing of the handlers a replay exercises, reported when it ends */
+enum perf_id {
+	PERF_BUTTON,
+	PERF_AXIS,
+	PERF_SCROLL_TICK,
+	PERF_SCROLL_DRAG_TICK,
+	PERF_MOVE_SCROLL_TICK,
+	PERF_SELECT_TICK,
+	PERF_ZOOM_TICK,
+	PERF_CURSOR_TICK,
+	PERF_CLICK_TIMEOUT,
+	PERF_POINTER_MOTION,
+	PERF_RESIZE_TICK,
+	PERF_GESTURE,
+	PERF_SPAWN,
+	PERF_SPAWN_VISIBLE,
+	PERF_SPAWN_EXPIRE_TICK,
+	PERF_MAP_TICK,
+	PERF_FOCUS_CENTRED,
+	PERF_CAMERA_TICK,
+	PERF_CONTROL,
+	PERF_SPAWNER,
+	PERF_NEWWINDOW,
+	PERF_DISPATCH,
+	PERF_COUNT,
+};
+
+struct perf {
+	const char *name;
+	wl_event_loop_timer_func_t tick;
+	bool latency; /* a wait rather than work, the watchdog leaves it alone */
+	struct hist hist;
+	uint16_t trace_name;
+};
+
+/* requests are profiled per message and per client pid, in two small open
+ * addressed tables. once a table is 3/4 full the rest share its other slot */
+#define PROF_BITS 6
+#define PROF_SLOTS (1 << PROF_BITS)
+
+struct prof_slot {
+	const void *key;
+	char name[48];
+	uint16_t trace_name;
+	uint8_t kind; /* enum tele_kind */
+	struct hist hist;
+};
+
+struct prof_table {
+	struct prof_slot slots[PROF_SLOTS], other;
+	unsigned used;
+};
+
+/* a mura_scroll resource and the camera it was last sent */
+struct scroll_client {
+	struct wl_resource *resource;
+	struct wl_list link;
+	uint64_t interval; /* ns between updates, 0 for every frame */
+	uint64_t last;
+	int64_t x, y;
+	float zoom;
+	uint32_t focus;
+	bool paged; /* reads the camera page, gets no events */
+};
 
-static bool debugscroll = false;
 static struct {
 	struct wl_display *display;
 	struct wl_event_loop *evloop;
 	struct wl_list windows;
+	struct wl_list window_pids[PID_BUCKETS];
+	struct wl_list procs[PID_BUCKETS];
 	struct wl_list screens;
 	struct screen *current_screen;
 	struct swc_window *focused;
@@ -74,13 +287,13 @@ static struct {
 		bool jumping;
 		int32_t move_start_win_x, move_start_win_y;
 		int32_t move_start_cursor_x, move_start_cursor_y;
+		int32_t move_edge_velocity;
+		int32_t motion_x, motion_y;
 		int32_t scroll_rem, scroll_rem_x;
 		int32_t scroll_pending_px, scroll_pending_px_x;
+		uint64_t centre_start; /* a focus change started centring */
 		int8_t scroll_cursor_dir;
 		struct wl_event_source *scroll_timer;
-		struct swc_window *scroll_last;
-		struct swc_rectangle scroll_last_geo;
-		int32_t scroll_last_step;
 		bool selecting;
 		struct wl_event_source *timer;
 		int32_t start_x, start_y;
@@ -94,1327 +307,4629 @@ static struct {
 			uint32_t button;
 			uint32_t time;
 		} click;
-		struct {
-			bool pending;
-			struct swc_rectangle geometry;
-		} spawn;
 		int32_t scroll_drag_last_x, scroll_drag_last_y;
 		struct wl_event_source *scroll_drag_timer;
 		float zoom_target;
 		struct wl_event_source *zoom_timer;
+		struct {
+			struct swc_window *window;
+			struct swc_rectangle start;
+			int32_t cursor_x, cursor_y;
+			uint32_t width, height;           /* what the pointer asks for */
+			uint32_t sent_width, sent_height; /* last configure */
+			uint64_t sent_at;
+			bool outstanding, acked;
+			struct wl_event_source *timer;
+		} sizing;
 	} chord;
+	struct {
+		int fd;
+		struct wl_event_source *source;
+		uint32_t next_token;
+	} spawner;
+	struct wl_list spawns;
+	struct wl_event_source *spawn_timer;
+	int map_pending;
+	struct wl_event_source *map_timer;
+	struct {
+		unsigned hits, misses;
+	} pool;
+	struct {
+		struct libinput *li;
+		struct wl_event_source *source;
+		struct udev_monitor *monitor;
+		struct wl_event_source *monitor_source;
+		struct wl_list devices;
+		double rem_x, rem_y;
+		double vel_x, vel_y; /* px per ms */
+		uint64_t last_usec;
+		float zoom_start;
+	} gesture;
+	struct {
+		FILE *record;
+		uint64_t record_start;
+		int32_t record_x, record_y;
+		struct input_event *events;
+		size_t nevents, next;
+		bool replaying, feeding, fast;
+		int32_t x, y;
+		uint64_t replay_start;
+		struct wl_event_source *replay_timer;
+	} input;
+	struct {
+		struct wl_protocol_logger *logger;
+		/* the request running since start, closed by the next timed thing */
+		struct prof_slot *request, *client;
+		pid_t pid;
+		uint64_t start;
+		bool slow_seen; /* this dispatch already reported something slow */
+		uint64_t slow_last;
+		unsigned slow_suppressed;
+	} prof;
+	struct {
+		struct wl_list surfaces;
+		/* the surface whose request is running, for newwindow() */
+		struct surface_stat *current;
+		/* a frame request whose callback is not made yet */
+		struct surface_stat *frame_surface;
+		uint32_t frame_id;
+		uint32_t next_window_id;
+	} tele;
+	struct {
+		/* how far the plane has moved, what mura_scroll reports */
+		int64_t x, y;
+		struct wl_list clients;
+		struct wl_event_source *timer;
+		bool armed;
+		/* made on the first get_page, shared by every client */
+		struct camera_page *page;
+		int page_fd;
+	} camera;
+	struct {
+		/* where the windows are on the plane, for pan() to stay inside
+		 * 32 bits. grows as pans move windows that stay on the screen,
+		 * worked out again after any other move */
+		int64_t min_x, max_x, min_y, max_y;
+		bool empty, stale;
+	} plane;
+	struct {
+		struct wl_list clients, dirty;
+		/* listed windows destroyed since the last frame */
+		uint32_t *closed;
+		size_t nclosed, closed_cap;
+		uint32_t sent_focus;
+		int64_t sent_x, sent_y;
+		/* sent to version 2 clients only */
+		int64_t view_x, view_y;
+		uint32_t view_width, view_height;
+		struct window *last; /* the last window looked up by its swc */
+	} wlist;
+	struct {
+		int fd;
+		struct wl_event_source *source;
+		struct wl_list clients;
+		char path[108];
+	} control;
 } mura;
 
 static int scroll_tick(void *data);
 static void scroll_stop(void);
 static int zoom_tick(void *data);
+static int select_tick(void *data);
+static int move_scroll_tick(void *data);
+static int cursor_tick(void *data);
+static int scroll_drag_tick(void *data);
+static int click_timeout(void *data);
+static int resize_tick(void *data);
+static int spawn_expire_tick(void *data);
+static int map_tick(void *data);
+static int camera_tick(void *data);
+static void wlist_changed(struct window *w, uint8_t bits);
+static void pan_to(int64_t x, int64_t y);
+static void proc_add(pid_t pid, pid_t ppid);
+static void swallow_answered(pid_t pid);
+static void spawn_token_answered(pid_t pid, uint32_t token);
+static bool spawner_start(void);
 static bool is_visible(struct swc_window *w, struct screen *screen);
 
-static void
-remove_resource(struct wl_resource *resource)
+static struct perf perf[PERF_COUNT] = {
+	[PERF_BUTTON]           = { "button" },
+	[PERF_AXIS]             = { "axis" },
+	[PERF_SCROLL_TICK]      = { "scroll_tick", scroll_tick },
+	[PERF_SCROLL_DRAG_TICK] = { "scroll_drag_tick", scroll_drag_tick },
+	[PERF_MOVE_SCROLL_TICK] = { "move_scroll_tick", move_scroll_tick },
+	[PERF_SELECT_TICK]      = { "select_tick", select_tick },
+	[PERF_ZOOM_TICK]        = { "zoom_tick", zoom_tick },
+	[PERF_CURSOR_TICK]      = { "cursor_tick", cursor_tick },
+	[PERF_CLICK_TIMEOUT]    = { "click_timeout", click_timeout },
+	[PERF_POINTER_MOTION]   = { "pointer_motion" },
+	[PERF_RESIZE_TICK]      = { "resize_tick", resize_tick },
+	[PERF_GESTURE]          = { "gesture" },
+	[PERF_SPAWN]            = { "spawn" },
+	[PERF_SPAWN_VISIBLE]    = { "spawn_to_visible", NULL, true },
+	[PERF_SPAWN_EXPIRE_TICK] = { "spawn_expire_tick", spawn_expire_tick },
+	[PERF_MAP_TICK]         = { "map_tick", map_tick },
+	[PERF_FOCUS_CENTRED]    = { "focus_to_centred", NULL, true },
+	[PERF_CAMERA_TICK]      = { "camera_tick", camera_tick },
+	[PERF_CONTROL]          = { "control" },
+	[PERF_SPAWNER]          = { "spawner" },
+	[PERF_NEWWINDOW]        = { "newwindow" },
+	[PERF_DISPATCH]         = { "dispatch" },
+};
+
+static struct prof_table prof_requests = { .other.name = "req:other" };
+static struct prof_table prof_clients = { .other.name = "client:other" };
+
+static uint64_t
+now_nsec(void)
 {
-	wl_list_remove(wl_resource_get_link(resource));
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
 }
 
-void
-bind_scrollpos(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+static uint32_t
+saturate(uint64_t v)
 {
-	(void)data;
-	struct wl_resource *resource;
+	return v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
 
-	if (version >= 1)
-		version = 1;
+static int64_t
+clamp64(int64_t v, int64_t lo, int64_t hi)
+{
+	return v < lo ? lo : v > hi ? hi : v;
+}
+
+static bool
+is_slow(uint64_t ns)
+{
+	return slow_handler_ms && ns >= (uint64_t)slow_handler_ms * 1000000;
+}
 
-	resource = wl_resource_create(client, &mura_scroll_interface, version, id);
+/* every slow handler goes to the trace ring, stderr gets at most one line a
+ * second so a stall cannot turn into a flood */
+static void
+slow_report(const char *name, uint16_t trace_name, uint64_t start, uint64_t ns, pid_t pid)
+{
+	mura.prof.slow_seen = true;
+	TRACE(TRACE_SLOW, trace_name, start, saturate(ns), pid, 0);
 
-	if(!resource) {
-		wl_client_post_no_memory(client);
+	if (mura.prof.slow_last && start - mura.prof.slow_last < 1000000000) {
+		mura.prof.slow_suppressed++;
 		return;
 	}
+	fprintf(stderr, "slow: %s took %.1f ms", name, ns / 1e6);
+	if (pid)
+		fprintf(stderr, " for pid %d", (int)pid);
+	if (mura.prof.slow_suppressed)
+		fprintf(stderr, ", %u more in the last second", mura.prof.slow_suppressed);
+	fputc('\n', stderr);
+	mura.prof.slow_last = start;
+	mura.prof.slow_suppressed = 0;
+}
 
-	wl_resource_set_implementation(resource, NULL, NULL, remove_resource);
-	wl_list_insert(&scrollpos_resources, wl_resource_get_link(resource));
+static void
+perf_add(enum perf_id id, uint64_t start)
+{
+	uint64_t ns = now_nsec() - start;
 
-	mura_scroll_send_get_pos(resource, scrollpos);
+	hist_add(&perf[id].hist, ns);
+	TRACE(TRACE_SPAN, perf[id].trace_name, start, saturate(ns), 0, 0);
+	/* a slow dispatch is only news when nothing inside it was reported */
+	if (!perf[id].latency && is_slow(ns) && (id != PERF_DISPATCH || !mura.prof.slow_seen))
+		slow_report(perf[id].name, perf[id].trace_name, start, ns, 0);
 }
 
-void
-send_scrollpos(void)
+static struct prof_slot *
+prof_slot(struct prof_table *t, const void *key)
 {
-	struct wl_resource *resource;
+	size_t i = (uint32_t)((uintptr_t)key * 2654435761u) >> (32 - PROF_BITS);
+
+	for (;; i++) {
+		struct prof_slot *slot = &t->slots[i & (PROF_SLOTS - 1)];
 
-	wl_resource_for_each(resource, &scrollpos_resources)
-		mura_scroll_send_get_pos(resource, scrollpos);
+		if (slot->key == key)
+			return slot;
+		if (slot->key)
+			continue;
+		if (t->used >= PROF_SLOTS / 4 * 3)
+			return &t->other;
+		t->used++;
+		slot->key = key;
+		return slot;
+	}
 }
 
 static void
-focus_window(struct swc_window *swc, const char *reason)
+prof_name(struct prof_slot *slot, const char *fmt, ...)
 {
-	const char *from = mura.focused && mura.focused->title ? mura.focused->title : "";
-	const char *to = swc && swc->title ? swc->title : "";
+	va_list ap;
 
-	if(mura.focused == swc)
-		return;
-	printf("focus %p ('%s') -> %p ('%s') (%s)\n",
-	       (void *)mura.focused, from, (void *)swc, to, reason);
+	va_start(ap, fmt);
+	vsnprintf(slot->name, sizeof(slot->name), fmt, ap);
+	va_end(ap);
+	if (trace_ring)
+		slot->trace_name = trace_string(slot->name);
+}
 
-	if(mura.focused)
-		swc_window_set_border(mura.focused, inner_border_color_inactive, inner_border_width, outer_border_color_inactive, outer_border_width);
+static uint8_t
+tele_kind(const char *interface, const char *request)
+{
+	static const struct {
+		const char *interface, *request;
+		enum tele_kind kind;
+	} kinds[] = {
+		{ "wl_surface", "attach", TELE_ATTACH },
+		{ "wl_surface", "damage", TELE_DAMAGE },
+		{ "wl_surface", "damage_buffer", TELE_DAMAGE },
+		{ "wl_surface", "frame", TELE_FRAME },
+		{ "wl_surface", "commit", TELE_COMMIT },
+		{ "xdg_wm_base", "get_xdg_surface", TELE_XDG_SURFACE },
+		{ "xdg_surface", "get_toplevel", TELE_TOPLEVEL },
+		{ "xdg_surface", "ack_configure", TELE_ACK_CONFIGURE },
+	};
+
+	for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+		if (strcmp(kinds[i].interface, interface) == 0 && strcmp(kinds[i].request, request) == 0)
+			return kinds[i].kind;
+	}
+	return TELE_NONE;
+}
 
-	swc_window_focus(swc);
+static void
+surface_stat_destroy(struct wl_listener *listener, void *data)
+{
+	struct surface_stat *s = wl_container_of(listener, s, destroy);
 
-	/* zoom to default size when focusing a window */
-	if (enable_zoom && swc && swc_get_zoom() != 1.0f) {
-		mura.chord.zoom_target = 1.0f;
-		if (!mura.chord.zoom_timer)
-			mura.chord.zoom_timer = wl_event_loop_add_timer(mura.evloop, zoom_tick, NULL);
-		if (mura.chord.zoom_timer)
-			wl_event_source_timer_update(mura.chord.zoom_timer, 1);
+	(void)data;
+	for (int i = 0; i < TELE_FRAMES; i++) {
+		if (s->watches[i].surface)
+			wl_list_remove(&s->watches[i].destroy.link);
 	}
+	if (s->window)
+		s->window->stat = NULL;
+	if (mura.tele.current == s)
+		mura.tele.current = NULL;
+	if (mura.tele.frame_surface == s)
+		mura.tele.frame_surface = NULL;
+	wl_list_remove(&s->link);
+	free(s);
+}
 
-	if(swc)
-		swc_window_set_border(swc, inner_border_color_active, inner_border_width, outer_border_color_active, outer_border_width);
+/* the stats ride along as a destroy listener, so finding them is a walk
+ * over the surface's few listeners */
+static struct surface_stat *
+surface_stat_get(struct wl_resource *surface)
+{
+	struct wl_listener *l = wl_resource_get_destroy_listener(surface, surface_stat_destroy);
+	struct surface_stat *s;
+
+	if (l)
+		return wl_container_of(l, s, destroy);
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+	s->surface = surface;
+	s->destroy.notify = surface_stat_destroy;
+	wl_resource_add_destroy_listener(surface, &s->destroy);
+	wl_list_insert(&mura.tele.surfaces, &s->link);
+	return s;
+}
 
-	mura.focused = swc;
+static void
+frame_done(struct wl_listener *listener, void *data)
+{
+	struct frame_watch *fw = wl_container_of(listener, fw, destroy);
 
-	/* center the focused window: both axes in drag mode, vertical only in scroll wheel mode, only when visible or jumping to it, else you can center offscreen windows */
-	if (focus_center == true && swc && mura.current_screen && (is_visible(mura.focused, mura.current_screen) || mura.chord.jumping == true)) {
-		struct swc_rectangle window_geom;
+	(void)data;
+	wl_list_remove(&fw->destroy.link);
+	fw->surface = NULL;
+}
 
-		if (swc_window_get_geometry(swc, &window_geom)) {
-			/* skip if window has no size yet (not configured by client) */
-			if (window_geom.width == 0 || window_geom.height == 0)
-				return;
+/* the callback of a frame request only exists once its handler has run,
+ * so it is picked up when the next request or handler starts. callbacks
+ * are destroyed right after done, which is what frees the watch */
+static void
+tele_flush(void)
+{
+	struct surface_stat *s = mura.tele.frame_surface;
+	struct wl_resource *callback;
 
-			int32_t window_center_x = window_geom.x + (int32_t)window_geom.width / 2;
-			int32_t window_center_y = window_geom.y + (int32_t)window_geom.height / 2;
-			int32_t screen_center_x = mura.current_screen->swc->geometry.x + (int32_t)mura.current_screen->swc->geometry.width / 2;
-			int32_t screen_center_y = mura.current_screen->swc->geometry.y + (int32_t)mura.current_screen->swc->geometry.height / 2;
+	if (!s)
+		return;
+	mura.tele.frame_surface = NULL;
+	callback = wl_client_get_object(wl_resource_get_client(s->surface), mura.tele.frame_id);
+	if (!callback)
+		return;
+	for (int i = 0; i < TELE_FRAMES; i++) {
+		struct frame_watch *fw = &s->watches[i];
 
-			/* in drag mode: center on both axes; in scroll wheel mode: vertical only */
-			int32_t scroll_delta_x = scroll_drag_mode ? (screen_center_x - window_center_x) : 0;
-			int32_t scroll_delta_y = screen_center_y - window_center_y;
+		if (fw->surface)
+			continue;
+		fw->surface = s;
+		fw->destroy.notify = frame_done;
+		wl_resource_add_destroy_listener(callback, &fw->destroy);
+		return;
+	}
+}
 
-			if (scroll_delta_x != 0 || scroll_delta_y != 0) {
-				/* stop scroll before auto-scroll */
-				scroll_stop();
+static void
+tele_attach(struct surface_stat *s, struct wl_resource *buffer)
+{
+	struct wl_shm_buffer *shm;
+	int i;
 
-				mura.chord.scroll_pending_px = scroll_delta_y;
-				mura.chord.scroll_pending_px_x = scroll_delta_x;
-				mura.chord.scroll_rem = 0;
-				mura.chord.scroll_rem_x = 0;
-				mura.chord.auto_scrolling = true;
+	if (!buffer)
+		return;
+	shm = wl_shm_buffer_get(buffer);
+	if (shm) {
+		s->width = (uint32_t)wl_shm_buffer_get_width(shm);
+		s->height = (uint32_t)wl_shm_buffer_get_height(shm);
+		s->format = wl_shm_buffer_get_format(shm);
+		s->bytes = (uint32_t)wl_shm_buffer_get_stride(shm) * s->height;
+	} else {
+		/* dmabufs say nothing here, mura-top falls back to the window */
+		s->width = s->height = s->bytes = 0;
+		s->format = TELE_FORMAT_GPU;
+	}
+	for (i = 0; i < TELE_BUFFERS; i++) {
+		if (s->buffers[i] == buffer)
+			return;
+	}
+	s->buffers[s->next_buffer++ % TELE_BUFFERS] = buffer;
+}
 
-				if (!mura.chord.scroll_timer) {
-					mura.chord.scroll_timer = wl_event_loop_add_timer(
-						mura.evloop, scroll_tick, NULL);
-				}
-				wl_event_source_timer_update(mura.chord.scroll_timer, timerms);
-			}
+static uint32_t
+tele_clip(int32_t v, uint32_t limit)
+{
+	if (v <= 0)
+		return 0;
+	return (uint32_t)v < limit ? (uint32_t)v : limit;
+}
+
+static void
+tele_request(enum tele_kind kind, const struct wl_protocol_logger_message *m)
+{
+	const union wl_argument *arg = m->arguments;
+	struct wl_client *client;
+	struct surface_stat *s;
+	uint64_t area;
+	uint32_t id;
+
+	if (kind == TELE_TOPLEVEL || kind == TELE_ACK_CONFIGURE) {
+		/* acks only matter to a resize waiting on one */
+		if (kind == TELE_ACK_CONFIGURE && !mura.chord.sizing.outstanding)
+			return;
+		client = wl_resource_get_client(m->resource);
+		id = wl_resource_get_id(m->resource);
+		wl_list_for_each(s, &mura.tele.surfaces, link) {
+			if (s->xdg_id != id || wl_resource_get_client(s->surface) != client)
+				continue;
+			if (kind == TELE_TOPLEVEL)
+				mura.tele.current = s;
+			else if (s->window && s->window->swc == mura.chord.sizing.window)
+				mura.chord.sizing.acked = true;
+			break;
+		}
+		return;
+	}
+
+	s = surface_stat_get(kind == TELE_XDG_SURFACE ? arg[1].o : m->resource);
+	if (!s)
+		return;
+	switch (kind) {
+	case TELE_XDG_SURFACE:
+		s->xdg_id = arg[0].n;
+		break;
+	case TELE_ATTACH:
+		tele_attach(s, arg[0].o);
+		break;
+	case TELE_DAMAGE:
+		/* INT32_MAX wide and high is a common way to say everything */
+		s->damage_pending += (uint64_t)tele_clip(arg[2].i, s->width ? s->width : 8192) *
+		                     tele_clip(arg[3].i, s->height ? s->height : 8192);
+		break;
+	case TELE_FRAME:
+		s->frames++;
+		mura.tele.frame_surface = s;
+		mura.tele.frame_id = arg[0].n;
+		break;
+	case TELE_COMMIT:
+		area = (uint64_t)s->width * s->height;
+		if (area && s->damage_pending > area)
+			s->damage_pending = area;
+		s->commits++;
+		s->damage += s->damage_pending;
+		s->damage_pending = 0;
+		mura.tele.current = s;
+		/* the client may have picked a new size */
+		if (s->window)
+			wlist_changed(s->window, WLIST_GEOMETRY);
+		/* the commit after an ack carries the configured size, or the
+		 * size the client settled on instead */
+		if (mura.chord.sizing.acked && s->window && s->window->swc == mura.chord.sizing.window) {
+			mura.chord.sizing.acked = false;
+			mura.chord.sizing.outstanding = false;
 		}
+		break;
+	default:
+		break;
 	}
 }
 
-static bool
-cursor_position_raw(int32_t *x, int32_t *y)
+/* charge the time since the last request started to it and its client */
+static void
+prof_close(uint64_t now)
 {
-	int32_t fx, fy;
+	struct prof_slot *req = mura.prof.request;
+	uint64_t ns;
 
-	if(!swc_cursor_position(&fx, &fy))
-		return false;
-	*x = wl_fixed_to_int(fx);
-	*y = wl_fixed_to_int(fy);
-	return true;
+	tele_flush();
+	if (!req)
+		return;
+	mura.prof.request = NULL;
+	ns = now - mura.prof.start;
+	hist_add(&req->hist, ns);
+	hist_add(&mura.prof.client->hist, ns);
+	TRACE(TRACE_SPAN, req->trace_name, mura.prof.start, saturate(ns), mura.prof.pid, 0);
+	if (is_slow(ns))
+		slow_report(req->name, req->trace_name, mura.prof.start, ns, mura.prof.pid);
 }
 
-static bool
-cursor_position(int32_t *x, int32_t *y)
+/* libwayland calls this right before it runs a request's handler. the
+ * surface stats are kept whether or not requests are timed: mura_windows
+ * learns of client resizes from the commits */
+static void
+prof_request(void *data, enum wl_protocol_logger_type type, const struct wl_protocol_logger_message *m)
 {
-	if(!cursor_position_raw(x, y))
-		return false;
+	struct prof_slot *slot;
+	uint64_t now;
+	pid_t pid;
 
-	if (enable_zoom) {
-		float zoom = swc_get_zoom();
-		if (zoom != 1.0f && mura.current_screen) {
-			int32_t cx = mura.current_screen->swc->geometry.x + mura.current_screen->swc->geometry.width / 2;
-			int32_t cy = mura.current_screen->swc->geometry.y + mura.current_screen->swc->geometry.height / 2;
-			*x = (int32_t)((*x - cx) / zoom) + cx;
-			*y = (int32_t)((*y - cy) / zoom) + cy;
-		}
+	(void)data;
+	if (type != WL_PROTOCOL_LOGGER_REQUEST)
+		return;
+
+	now = profile_requests ? now_nsec() : 0;
+	prof_close(now);
+
+	slot = prof_slot(&prof_requests, m->message);
+	if (!slot->name[0]) {
+		prof_name(slot, "req:%s.%s", wl_resource_get_class(m->resource), m->message->name);
+		slot->kind = tele_kind(wl_resource_get_class(m->resource), m->message->name);
 	}
+	mura.tele.current = NULL;
+	if (slot->kind)
+		tele_request(slot->kind, m);
+	if (!profile_requests)
+		return;
+	mura.prof.request = slot;
 
-	return true;
+	wl_client_get_credentials(wl_resource_get_client(m->resource), &pid, NULL, NULL);
+	slot = prof_slot(&prof_clients, (const void *)(uintptr_t)pid);
+	if (!slot->name[0])
+		prof_name(slot, "client:%d", (int)pid);
+	mura.prof.client = slot;
+
+	mura.prof.pid = pid;
+	mura.prof.start = now;
 }
 
-/* hacky sorta, only works for vertical cuz of this */
-static bool
-is_on_screen(struct swc_rectangle *window, struct screen *screen)
+/* handlers that run straight from the event loop start here, which ends
+ * whatever request was running before them */
+static uint64_t
+perf_start(void)
 {
-	struct swc_rectangle *geom = &screen->swc->geometry;
+	uint64_t now = now_nsec();
 
-	return window->x + (int32_t)window->width > geom->x && window->x < geom->x + (int32_t)geom->width;
+	prof_close(now);
+	return now;
+}
+
+/* windows show up in traces by address, which is stable while they live */
+static int32_t
+trace_window(struct swc_window *swc)
+{
+	return (int32_t)((uintptr_t)swc >> 4);
 }
 
 static bool
-is_visible(struct swc_window *w, struct screen *screen)
+trace_start(const char *path)
 {
-	struct swc_rectangle *geom = &screen->swc->geometry;
-	struct swc_rectangle wgeom;
-	swc_window_get_geometry(w, &wgeom);
+	if (!trace_open(path, trace_ring_records)) {
+		fprintf(stderr, "cannot open %s for tracing\n", path);
+		return false;
+	}
+	for (int i = 0; i < PERF_COUNT; i++)
+		perf[i].trace_name = trace_string(perf[i].name);
+	prof_requests.other.trace_name = trace_string(prof_requests.other.name);
+	prof_clients.other.trace_name = trace_string(prof_clients.other.name);
+	return true;
+}
 
-	bool h = wgeom.x + (int32_t)wgeom.width > geom->x && wgeom.x < geom->x + (int32_t)geom->width;
-	bool v = wgeom.y + (int32_t)wgeom.height > geom->y && wgeom.y < geom->y + (int32_t)geom->height;
+static int
+perf_tick(void *data)
+{
+	struct perf *p = data;
+	uint64_t start = perf_start();
+	int ret;
 
-	return h && v;
+	ret = p->tick(NULL);
+	perf_add((enum perf_id)(p - perf), start);
+	return ret;
+}
+
+/* all of mura's timers go through here so their callbacks get timed */
+static struct wl_event_source *
+add_timer(enum perf_id id)
+{
+	return wl_event_loop_add_timer(mura.evloop, perf_tick, &perf[id]);
 }
 
 static void
-world_to_screen(int32_t wx, int32_t wy, int32_t *sx, int32_t *sy)
+perf_report(FILE *f)
 {
-	if (enable_zoom) {
-		float zoom = swc_get_zoom();
-		if (zoom != 1.0f && mura.current_screen) {
-			int32_t cx = mura.current_screen->swc->geometry.x + mura.current_screen->swc->geometry.width / 2;
-			int32_t cy = mura.current_screen->swc->geometry.y + mura.current_screen->swc->geometry.height / 2;
-			*sx = (int32_t)((wx - cx) * zoom) + cx;
-			*sy = (int32_t)((wy - cy) * zoom) + cy;
-			return;
-		}
+	fprintf(f, "terminal pool: %u hits, %u misses\n", mura.pool.hits, mura.pool.misses);
+	fprintf(f, "%-18s %10s %12s %10s %10s %10s %10s\n",
+	        "handler", "calls", "total us", "mean ns", "p50 ns", "p99 ns", "max ns");
+	for (int i = 0; i < PERF_COUNT; i++) {
+		struct hist *h = &perf[i].hist;
+
+		fprintf(f, "%-18s %10" PRIu64 " %12" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+		        perf[i].name, h->count, h->total / 1000, h->count ? h->total / h->count : 0,
+		        hist_percentile(h, 50), hist_percentile(h, 99), h->max);
 	}
-	*sx = wx;
-	*sy = wy;
 }
 
-static bool
-is_acme(const struct swc_window *swc)
+/* pan, zoom and focus changes only arm the camera timer, so however often
+ * they happen a client hears about them once a frame at most */
+static void
+camera_arm(void)
 {
-	return swc && swc->app_id && strcmp(swc->app_id, "acme") == 0;
+	if (mura.camera.armed)
+		return;
+	if (!mura.camera.timer && !(mura.camera.timer = add_timer(PERF_CAMERA_TICK)))
+		return;
+	wl_event_source_timer_update(mura.camera.timer, timerms);
+	mura.camera.armed = true;
 }
 
 static void
-update_mode_cursor(void)
+camera_changed(void)
 {
-	if (mura.chord.killing)
-		swc_set_cursor(SWC_CURSOR_SIGHT);
-	else if (mura.chord.scrolling) {
-		if (mura.chord.scroll_cursor_dir < 0)
-			swc_set_cursor(SWC_CURSOR_UP);
-		else
-			swc_set_cursor(SWC_CURSOR_DOWN);
-	}
-	else if (mura.chord.selecting)
-		swc_set_cursor(SWC_CURSOR_CROSS);
-	else if (mura.chord.moving || mura.chord.resize)
-		swc_set_cursor(SWC_CURSOR_BOX);
-	else
-		swc_set_cursor(SWC_CURSOR_DEFAULT);
+	if (wl_list_empty(&mura.camera.clients) && !mura.camera.page &&
+	    wl_list_empty(&mura.wlist.clients))
+		return;
+	camera_arm();
 }
 
-static void
-maybe_enable_nein_cursor_theme(void)
+static uint32_t
+camera_focus(void)
 {
-	const struct nein_cursor_meta *arrow = &nein_cursor_metadata[NEIN_CURSOR_WHITEARROW];
-	const struct nein_cursor_meta *box = &nein_cursor_metadata[NEIN_CURSOR_BOXCURSOR];
-	const struct nein_cursor_meta *cross = &nein_cursor_metadata[NEIN_CURSOR_CROSSCURSOR];
-	const struct nein_cursor_meta *sight = &nein_cursor_metadata[NEIN_CURSOR_SIGHTCURSOR];
-	const struct nein_cursor_meta *up = &nein_cursor_metadata[NEIN_CURSOR_T];
-	const struct nein_cursor_meta *down = &nein_cursor_metadata[NEIN_CURSOR_B];
-
-	if (!cursor_theme || strcmp(cursor_theme, "nein") != 0)
-		return;
-
-	swc_set_cursor_mode(SWC_CURSOR_MODE_COMPOSITOR);
-	swc_set_cursor_image(SWC_CURSOR_DEFAULT, &nein_cursor_data[arrow->offset],
-	                     arrow->width, arrow->height,
-	                     arrow->hotspot_x, arrow->hotspot_y);
-	swc_set_cursor_image(SWC_CURSOR_BOX, &nein_cursor_data[box->offset],
-	                     box->width, box->height,
-	                     box->hotspot_x, box->hotspot_y);
-	swc_set_cursor_image(SWC_CURSOR_CROSS, &nein_cursor_data[cross->offset],
-	                     cross->width, cross->height,
-	                     cross->hotspot_x, cross->hotspot_y);
-	swc_set_cursor_image(SWC_CURSOR_SIGHT, &nein_cursor_data[sight->offset],
-	                     sight->width, sight->height,
-	                     sight->hotspot_x, sight->hotspot_y);
-	swc_set_cursor_image(SWC_CURSOR_UP, &nein_cursor_data[up->offset],
-	                     up->width, up->height,
-	                     up->hotspot_x, up->hotspot_y);
-	swc_set_cursor_image(SWC_CURSOR_DOWN, &nein_cursor_data[down->offset],
-	                     down->width, down->height,
-	                     down->hotspot_x, down->hotspot_y);
+	struct window *w;
 
-	update_mode_cursor();
+	if (!mura.focused)
+		return 0;
+	wl_list_for_each(w, &mura.windows, link) {
+		if (w->swc == mura.focused)
+			return w->id;
+	}
+	return 0;
 }
 
 static void
-stop_select(void)
+scroll_send(struct scroll_client *c, float zoom, uint32_t focus, bool all)
 {
-	if(mura.chord.timer){
-		wl_event_source_remove(mura.chord.timer);
-		mura.chord.timer = NULL;
+	int64_t x = mura.camera.x, y = mura.camera.y;
+
+	if (wl_resource_get_version(c->resource) < 2) {
+		if (all || y != c->y)
+			mura_scroll_send_get_pos(c->resource, (int32_t)y);
+	} else {
+		if (all || x != c->x || y != c->y)
+			mura_scroll_send_position(c->resource, (int32_t)(x >> 32), (uint32_t)x,
+			                          (int32_t)(y >> 32), (uint32_t)y);
+		if (all || zoom != c->zoom)
+			mura_scroll_send_zoom(c->resource, wl_fixed_from_double(zoom));
+		if (all || focus != c->focus)
+			mura_scroll_send_focus(c->resource, focus);
+		mura_scroll_send_done(c->resource);
 	}
-	mura.chord.selecting = false;
-	swc_overlay_clear();
-	update_mode_cursor();
+	c->x = x;
+	c->y = y;
+	c->zoom = zoom;
+	c->focus = focus;
 }
 
-static int scroll_tick(void *data);
+static void
+camera_publish(float zoom, uint32_t focus, uint64_t now)
+{
+	struct camera_page *p = mura.camera.page;
+	uint32_t seq = p->seq;
+
+	__atomic_store_n(&p->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&p->focus, focus, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->x, mura.camera.x, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->y, mura.camera.y, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->zoom, (uint32_t)(zoom * 65536.0f + 0.5f), __ATOMIC_RELAXED);
+	__atomic_store_n(&p->updates, p->updates + 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->time, now, __ATOMIC_RELAXED);
+	__atomic_store_n(&p->seq, seq + 2, __ATOMIC_RELEASE);
+}
 
 static int
-select_tick(void *data)
+camera_memfd(void)
 {
-	int32_t x, y;
+#ifdef SYS_memfd_create
+	return (int)syscall(SYS_memfd_create, "mura-camera", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+	char name[32];
+	int fd;
 
-	(void)data;
-	if(!mura.chord.selecting)
-		return 0;
+	snprintf(name, sizeof(name), "/mura-camera-%d", (int)getpid());
+	if ((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600)) >= 0)
+		shm_unlink(name);
+	return fd;
+#endif
+}
 
-	if(cursor_position(&x, &y)){
-		mura.chord.cur_x = x;
-		mura.chord.cur_y = y;
-		swc_overlay_set_box(mura.chord.start_x, mura.chord.start_y, x, y,
-		                    select_box_color, select_box_border);
+/* the page's size is sealed so a reader cannot be made to fault, and once
+ * mura has it mapped no one else can map it writable */
+static bool
+camera_page_create(void)
+{
+	struct camera_page *p;
+	int fd;
+
+	if ((fd = camera_memfd()) < 0)
+		return false;
+	if (ftruncate(fd, sizeof(*p)) < 0) {
+		close(fd);
+		return false;
+	}
+	p = mmap(NULL, sizeof(*p), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (p == MAP_FAILED) {
+		close(fd);
+		return false;
 	}
+#ifdef __linux__
+	fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW);
+	fcntl(fd, F_ADD_SEALS, F_SEAL_FUTURE_WRITE);
+#endif
+	p->version = CAMERA_VERSION;
+	mura.camera.page = p;
+	mura.camera.page_fd = fd;
+	camera_publish(swc_get_zoom(), camera_focus(), now_nsec());
+	__atomic_store_n(&p->magic, CAMERA_MAGIC, __ATOMIC_RELEASE);
+	return true;
+}
 
-	wl_event_source_timer_update(mura.chord.timer, timerms);
-	return 0;
+/* windows mura_windows knows about: not waiting in the pool or for their
+ * first buffer */
+static bool
+wlist_listable(struct window *w)
+{
+	return w->swc && !w->pooled && !w->map_pending;
 }
 
-static int
-move_scroll_tick(void *data)
+static void
+wlist_changed(struct window *w, uint8_t bits)
 {
-	int32_t x, y;
-	struct swc_rectangle geometry;
-	int32_t screen_height = 0;
+	if (bits & WLIST_GEOMETRY)
+		mura.plane.stale = true;
+	if (wl_list_empty(&mura.wlist.clients))
+		return;
+	if (!w->dirty)
+		wl_list_insert(mura.wlist.dirty.prev, &w->dirty_link);
+	w->dirty |= bits;
+	camera_arm();
+}
 
-	(void)data;
-	if(!mura.chord.moving)
-		return 0;
+/* for the places that only have the swc window, mostly the one being
+ * dragged, so the last one found is tried first */
+static void
+wlist_moved(struct swc_window *swc)
+{
+	struct window *w;
 
-	/* get screen size*/
-	if(mura.current_screen){
-		screen_height = mura.current_screen->swc->geometry.height;
+	mura.plane.stale = true;
+	if (!swc || wl_list_empty(&mura.wlist.clients))
+		return;
+	if (mura.wlist.last && mura.wlist.last->swc == swc) {
+		wlist_changed(mura.wlist.last, WLIST_GEOMETRY);
+		return;
 	}
-
-	if(screen_height == 0){
-		wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
-		return 0;
+	wl_list_for_each(w, &mura.windows, link) {
+		if (w->swc == swc) {
+			mura.wlist.last = w;
+			wlist_changed(w, WLIST_GEOMETRY);
+			return;
+		}
 	}
+}
 
-	if(!cursor_position(&x, &y)){
-		wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
-		return 0;
+static void
+wlist_forget(struct window *w)
+{
+	uint32_t *closed;
+	size_t cap;
+
+	if (mura.wlist.last == w)
+		mura.wlist.last = NULL;
+	if (w->dirty) {
+		wl_list_remove(&w->dirty_link);
+		w->dirty = 0;
 	}
-
-	/* get where the where the window starts [line 558], every 16ms calculate where it should be
-	 * then move only <config-value>% of that gap, then next frame, move
-	 * <config-value>% of the new, smaller gap, exponential easing*/
-	if(mura.focused && swc_window_get_geometry(mura.focused, &geometry)){
-		int32_t target_x = mura.chord.move_start_win_x + (x - mura.chord.move_start_cursor_x);
-		int32_t target_y = mura.chord.move_start_win_y + (y - mura.chord.move_start_cursor_y);
-		int32_t new_x = geometry.x + (int32_t)((target_x - geometry.x) * move_ease_factor);
-		int32_t new_y = geometry.y + (int32_t)((target_y - geometry.y) * move_ease_factor);
-		swc_window_set_position(mura.focused, new_x, new_y);
+	if (!w->listed || wl_list_empty(&mura.wlist.clients))
+		return;
+	if (mura.wlist.nclosed == mura.wlist.closed_cap) {
+		cap = mura.wlist.closed_cap ? mura.wlist.closed_cap * 2 : 16;
+		if (!(closed = realloc(mura.wlist.closed, cap * sizeof(*closed))))
+			return;
+		mura.wlist.closed = closed;
+		mura.wlist.closed_cap = cap;
 	}
+	mura.wlist.closed[mura.wlist.nclosed++] = w->id;
+	camera_arm();
+}
 
-	/* check near top bottom and scroll accordingly */
-	if(y < move_scroll_edge_threshold){
-		mura.chord.scroll_pending_px += move_scroll_speed;
-		if(!mura.chord.scroll_timer)
-			mura.chord.scroll_timer = wl_event_loop_add_timer(mura.evloop, scroll_tick, NULL);
-		if(mura.chord.scroll_timer)
-			wl_event_source_timer_update(mura.chord.scroll_timer, 1);
-	} else if(y > screen_height - move_scroll_edge_threshold){
-		mura.chord.scroll_pending_px -= move_scroll_speed;
-		if(!mura.chord.scroll_timer)
-			mura.chord.scroll_timer = wl_event_loop_add_timer(mura.evloop, scroll_tick, NULL);
-		if(mura.chord.scroll_timer)
-			wl_event_source_timer_update(mura.chord.scroll_timer, 1);
+/* the window's place on the plane, which panning leaves alone */
+static void
+wlist_update(struct window *w)
+{
+	struct swc_rectangle geometry;
+
+	if (swc_window_get_geometry(w->swc, &geometry)) {
+		w->sent_x = geometry.x - mura.camera.x;
+		w->sent_y = geometry.y - mura.camera.y;
+		w->sent_width = geometry.width;
+		w->sent_height = geometry.height;
 	}
+	w->sent_visible = !w->hidden_for_spawn;
+}
 
-	wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
-	return 0;
+static void
+wlist_send(struct wl_resource *resource, struct window *w, uint8_t bits, bool new)
+{
+	if (new)
+		mura_windows_send_window(resource, w->id, w->pid);
+	if (bits & WLIST_GEOMETRY)
+		mura_windows_send_geometry(resource, w->id, (int32_t)(w->sent_x >> 32), (uint32_t)w->sent_x,
+		                           (int32_t)(w->sent_y >> 32), (uint32_t)w->sent_y,
+		                           w->sent_width, w->sent_height);
+	if (bits & WLIST_TITLE)
+		mura_windows_send_title(resource, w->id, w->swc->title);
+	if (bits & WLIST_APP_ID)
+		mura_windows_send_app_id(resource, w->id, w->swc->app_id);
+	if ((bits & WLIST_VISIBLE) && (!new || !w->sent_visible))
+		mura_windows_send_visible(resource, w->id, w->sent_visible);
 }
 
 static void
-spawn_term_select(const struct swc_rectangle *geometry)
+wlist_send_camera(struct wl_resource *resource)
 {
-	pid_t pid;
+	mura_windows_send_camera(resource, (int32_t)(mura.wlist.sent_x >> 32), (uint32_t)mura.wlist.sent_x,
+	                         (int32_t)(mura.wlist.sent_y >> 32), (uint32_t)mura.wlist.sent_y);
+}
 
-	mura.chord.spawn.pending = true;
-	mura.chord.spawn.geometry = *geometry;
+/* the current screen on the plane, unzoomed about its centre the way
+ * cursor_position() does it */
+static bool
+wlist_view(int64_t *x, int64_t *y, uint32_t *width, uint32_t *height)
+{
+	struct swc_rectangle *geom;
+	float zoom = enable_zoom ? swc_get_zoom() : 1.0f;
 
-	pid = fork();
-	if(pid == 0){
-		execlp(term, term, term_flag, select_term_app_id, NULL);
-		_exit(127);
-	}
+	if (!mura.current_screen)
+		return false;
+	if (zoom <= 0)
+		zoom = 1.0f;
+	geom = &mura.current_screen->swc->geometry;
+	*width = (uint32_t)(geom->width / zoom);
+	*height = (uint32_t)(geom->height / zoom);
+	*x = geom->x + (int64_t)(geom->width / 2) - *width / 2 - mura.camera.x;
+	*y = geom->y + (int64_t)(geom->height / 2) - *height / 2 - mura.camera.y;
+	return true;
 }
 
-static void click_cancel(void);
+static void
+wlist_send_view(struct wl_resource *resource)
+{
+	if (wl_resource_get_version(resource) < 2)
+		return;
+	mura_windows_send_view(resource, (int32_t)(mura.wlist.view_x >> 32), (uint32_t)mura.wlist.view_x,
+	                       (int32_t)(mura.wlist.view_y >> 32), (uint32_t)mura.wlist.view_y,
+	                       mura.wlist.view_width, mura.wlist.view_height);
+}
 
-static int
-click_timeout(void *data)
+/* one frame's worth of changes. windows panned with the plane are not
+ * touched here at all, the camera event covers them */
+static void
+wlist_flush(uint32_t focus)
 {
-	(void)data;
+	struct wl_resource *resource;
+	struct window *w, *tmp;
+	bool changed = false, new;
+	int64_t x, y;
+	uint32_t width, height;
+	bool visible;
+	uint8_t bits;
+
+	for (size_t i = 0; i < mura.wlist.nclosed; i++) {
+		wl_resource_for_each(resource, &mura.wlist.clients)
+			mura_windows_send_closed(resource, mura.wlist.closed[i]);
+		changed = true;
+	}
+	mura.wlist.nclosed = 0;
 
-	if(!mura.chord.click.pending)
-		return 0;
+	wl_list_for_each_safe(w, tmp, &mura.wlist.dirty, dirty_link) {
+		bits = w->dirty;
+		wl_list_remove(&w->dirty_link);
+		w->dirty = 0;
+		if (!wlist_listable(w))
+			continue;
+		new = !w->listed;
+		x = w->sent_x;
+		y = w->sent_y;
+		width = w->sent_width;
+		height = w->sent_height;
+		visible = w->sent_visible;
+		wlist_update(w);
+		if (new) {
+			bits = WLIST_ALL;
+		} else {
+			if (x == w->sent_x && y == w->sent_y && width == w->sent_width && height == w->sent_height)
+				bits &= ~WLIST_GEOMETRY;
+			if (visible == w->sent_visible)
+				bits &= ~WLIST_VISIBLE;
+			if (!bits)
+				continue;
+		}
+		wl_resource_for_each(resource, &mura.wlist.clients)
+			wlist_send(resource, w, bits, new);
+		w->listed = true;
+		changed = true;
+	}
 
-	/* don't forward clicks while move chord is active */
-	if (mura.chord.moving) {
-		click_cancel();
-		return 0;
+	if (focus != mura.wlist.sent_focus) {
+		mura.wlist.sent_focus = focus;
+		wl_resource_for_each(resource, &mura.wlist.clients)
+			mura_windows_send_focus(resource, focus);
+		changed = true;
+	}
+	if (mura.camera.x != mura.wlist.sent_x || mura.camera.y != mura.wlist.sent_y) {
+		mura.wlist.sent_x = mura.camera.x;
+		mura.wlist.sent_y = mura.camera.y;
+		wl_resource_for_each(resource, &mura.wlist.clients)
+			wlist_send_camera(resource);
+		changed = true;
 	}
+	if (wlist_view(&x, &y, &width, &height) &&
+	    (x != mura.wlist.view_x || y != mura.wlist.view_y ||
+	     width != mura.wlist.view_width || height != mura.wlist.view_height)) {
+		mura.wlist.view_x = x;
+		mura.wlist.view_y = y;
+		mura.wlist.view_width = width;
+		mura.wlist.view_height = height;
+		wl_resource_for_each(resource, &mura.wlist.clients)
+			wlist_send_view(resource);
+		changed = true;
+	}
+	if (changed) {
+		wl_resource_for_each(resource, &mura.wlist.clients)
+			mura_windows_send_done(resource);
+	}
+}
 
-	if(mura.chord.left && mura.chord.right)
-		return 0;
+static int
+camera_tick(void *data)
+{
+	struct scroll_client *c;
+	uint64_t now = now_nsec(), wait = 0, left;
+	float zoom = swc_get_zoom();
+	uint32_t focus = camera_focus();
 
-	if(!mura.chord.click.forwarded){
-		swc_pointer_send_button(mura.chord.click.time, mura.chord.click.button,
-		                        WL_POINTER_BUTTON_STATE_PRESSED);
-		mura.chord.click.forwarded = true;
+	(void)data;
+	mura.camera.armed = false;
+	if (mura.camera.page)
+		camera_publish(zoom, focus, now);
+	wl_list_for_each(c, &mura.camera.clients, link) {
+		if (c->paged)
+			continue;
+		if (c->x == mura.camera.x && c->y == mura.camera.y && c->zoom == zoom && c->focus == focus)
+			continue;
+		/* held back by its rate, the timer comes back for it */
+		if (c->interval && now - c->last < c->interval) {
+			left = c->interval - (now - c->last);
+			if (!wait || left < wait)
+				wait = left;
+			continue;
+		}
+		scroll_send(c, zoom, focus, false);
+		c->last = now;
+	}
+	if (!wl_list_empty(&mura.wlist.clients))
+		wlist_flush(focus);
+	if (wait) {
+		wl_event_source_timer_update(mura.camera.timer, (int)((wait + 999999) / 1000000));
+		mura.camera.armed = true;
 	}
-
 	return 0;
 }
 
 static void
-click_cancel(void)
+scroll_set_rate(struct wl_client *client, struct wl_resource *resource, uint32_t hz)
 {
-	if(mura.chord.click_timer){
-		wl_event_source_remove(mura.chord.click_timer);
-		mura.chord.click_timer = NULL;
-	}
-	mura.chord.click.pending = false;
-	mura.chord.click.forwarded = false;
+	struct scroll_client *c = wl_resource_get_user_data(resource);
+
+	(void)client;
+	c->interval = hz ? 1000000000 / hz : 0;
 }
 
 static void
-scroll_stop(void)
+scroll_get_page(struct wl_client *client, struct wl_resource *resource)
 {
-	mura.chord.scroll_pending_px = 0;
-	mura.chord.scroll_pending_px_x = 0;
-	mura.chord.scroll_rem = 0;
-	mura.chord.scroll_rem_x = 0;
-	mura.chord.scroll_last = NULL;
-	mura.chord.scroll_last_step = 0;
-	mura.chord.auto_scrolling = false;
+	struct scroll_client *c = wl_resource_get_user_data(resource);
 
-	/* stop drag timer */
-	if (mura.chord.scroll_drag_timer) {
-		wl_event_source_remove(mura.chord.scroll_drag_timer);
-		mura.chord.scroll_drag_timer = NULL;
+	if (!mura.camera.page && !camera_page_create()) {
+		wl_client_post_no_memory(client);
+		return;
 	}
+	c->paged = true;
+	mura_scroll_send_page(resource, mura.camera.page_fd, sizeof(*mura.camera.page));
 }
 
-static int
-cursor_tick(void *data)
+static void
+scroll_destroy(struct wl_client *client, struct wl_resource *resource)
 {
-	(void)data;
-
-	int32_t x, y;
-	struct screen *ns = NULL;
-
-	if (!cursor_position_raw(&x, &y)) {
-		wl_event_source_timer_update(mura.chord.cursor_timer, timerms);
-		return 0;
-	}
-
-	wl_list_for_each(ns, &mura.screens, link) {
-		struct swc_rectangle *geom = &ns->swc->geometry;
-
-		if(x >= geom->x && x < geom->x + (int32_t)geom->width &&
-				y >= geom->y && y < geom->y + (int32_t)geom->height) {
-
-			if(mura.current_screen != ns)
-				mura.current_screen = ns;
+	(void)client;
+	wl_resource_destroy(resource);
+}
 
-			break;
-		}
+static const struct mura_scroll_interface scroll_implementation = {
+	.destroy = scroll_destroy,
+	.set_rate = scroll_set_rate,
+	.get_page = scroll_get_page,
+};
 
-	}
+static void
+scroll_client_destroy(struct wl_resource *resource)
+{
+	struct scroll_client *c = wl_resource_get_user_data(resource);
 
-	wl_event_source_timer_update(mura.chord.cursor_timer, timerms);
-	return 0;
+	wl_list_remove(&c->link);
+	free(c);
 }
 
-static int
-zoom_tick(void *data)
+void
+bind_scrollpos(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 {
+	struct scroll_client *c;
+
 	(void)data;
+	if (version > 3)
+		version = 3;
 
-	float current = swc_get_zoom();
-	float target = mura.chord.zoom_target;
-	float diff = target - current;
-
-	/* Stop if close enough */
-	if (diff > -0.01f && diff < 0.01f) {
-		swc_set_zoom(target);
-		return 0;
+	if (!(c = calloc(1, sizeof(*c)))) {
+		wl_client_post_no_memory(client);
+		return;
+	}
+	c->resource = wl_resource_create(client, &mura_scroll_interface, version, id);
+	if (!c->resource) {
+		free(c);
+		wl_client_post_no_memory(client);
+		return;
 	}
 
-	/* Ease toward target */
-	float step = diff / 4.0f;
-	if (step > 0 && step < 0.01f) step = 0.01f;
-	if (step < 0 && step > -0.01f) step = -0.01f;
+	wl_resource_set_implementation(c->resource, &scroll_implementation, c, scroll_client_destroy);
+	wl_list_insert(&mura.camera.clients, &c->link);
 
-	swc_set_zoom(current + step);
+	c->last = now_nsec();
+	scroll_send(c, swc_get_zoom(), camera_focus(), true);
+}
 
-	/* Continue animation */
-	wl_event_source_timer_update(mura.chord.zoom_timer, timerms);
-	return 0;
+static void
+wlist_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	(void)client;
+	wl_resource_destroy(resource);
 }
 
-static int
-scroll_tick(void *data)
+static void
+wlist_look_at(struct wl_client *client, struct wl_resource *resource,
+              int32_t x_hi, uint32_t x_lo, int32_t y_hi, uint32_t y_lo)
 {
-	struct window *w, *tmp;
-	struct swc_rectangle geometry;
-	int32_t rem = mura.chord.scroll_pending_px;
-	int32_t rem_x = mura.chord.scroll_pending_px_x;
-	int32_t step, step_x;
-	static unsigned tickno;
+	int64_t x = (int64_t)((uint64_t)(uint32_t)x_hi << 32 | x_lo);
+	int64_t y = (int64_t)((uint64_t)(uint32_t)y_hi << 32 | y_lo);
+	struct swc_rectangle *geom;
 
-	(void)data;
+	(void)client;
+	(void)resource;
+	if (!mura.current_screen)
+		return;
+	/* zoom is about the centre, so it stays out of this. targets are
+	 * held to the 32 bits /scroll takes */
+	geom = &mura.current_screen->swc->geometry;
+	x = clamp64(x, INT32_MIN, INT32_MAX);
+	y = clamp64(y, INT32_MIN, INT32_MAX);
+	pan_to(geom->x + (int64_t)(geom->width / 2) - x, geom->y + (int64_t)(geom->height / 2) - y);
+}
 
-	if (!mura.chord.scroll_timer) {
-		if (debugscroll)
-			fprintf(stderr, "[scroll] tick with no timer\n");
-		return 0;
-	}
+static const struct mura_windows_interface wlist_implementation = {
+	.destroy = wlist_destroy,
+	.look_at = wlist_look_at,
+};
 
-	if ((!mura.chord.scrolling && !mura.chord.auto_scrolling && !mura.chord.moving) || (rem == 0 && rem_x == 0)) {
-		if (debugscroll && tickno % 10 == 0)
-			fprintf(stderr, "[scroll] tick stop scrolling=%d auto_scrolling=%d moving=%d rem=%d rem_x=%d\n", mura.chord.scrolling, mura.chord.auto_scrolling, mura.chord.moving, rem, rem_x);
-		scroll_stop();
-		return 0;
-	}
+static void
+wlist_resource_destroy(struct wl_resource *resource)
+{
+	wl_list_remove(wl_resource_get_link(resource));
+}
 
-	/* vertical step */
-	step = rem / scrollease;
-	if (step == 0 && rem != 0)
-		step = rem > 0 ? 1 : -1;
-	if (step > scrollcap)
-		step = scrollcap;
-	if (step < -scrollcap)
-		step = -scrollcap;
+/* with nobody listening nothing is tracked, so the first client starts
+ * from what is there now. later ones get what the others were sent, and
+ * whatever is still pending reaches them with the next frame */
+static void
+bind_windows(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	struct wl_resource *resource;
+	struct window *w;
 
-	/* horizontal step */
-	step_x = rem_x / scrollease;
-	if (step_x == 0 && rem_x != 0)
-		step_x = rem_x > 0 ? 1 : -1;
-	if (step_x > scrollcap)
-		step_x = scrollcap;
-	if (step_x < -scrollcap)
-		step_x = -scrollcap;
+	(void)data;
+	if (version > 2)
+		version = 2;
 
-	if (debugscroll && (++tickno % 10 == 0 || step == scrollcap || step == -scrollcap)) {
-		fprintf(stderr, "[scroll] tick rem=%d step=%d rem_x=%d step_x=%d last=%p\n",
-		        rem, step, rem_x, step_x, (void *)mura.chord.scroll_last);
+	resource = wl_resource_create(client, &mura_windows_interface, version, id);
+	if (!resource) {
+		wl_client_post_no_memory(client);
+		return;
 	}
+	wl_resource_set_implementation(resource, &wlist_implementation, NULL, wlist_resource_destroy);
 
-	scrollpos += step;
-	send_scrollpos();
-
-	wl_list_for_each_safe(w, tmp, &mura.windows, link) {
-		if (!w->swc) {
-			if (debugscroll)
-				fprintf(stderr, "[scroll] window node with null swc\n");
-			continue;
-		}
-
-		if (w->sticky)
-			continue;
-
-		/* when scroll with moving window, dont scroll the moving window, it makes it all jittery and ew */
-		if (mura.chord.moving && w->swc == mura.focused)
-			continue;
-		if (!swc_window_get_geometry(w->swc, &geometry))
-			continue;
-		if (!scroll_drag_mode && !is_on_screen(&geometry, mura.current_screen))
-			continue;
-
-		if (debugscroll) {
-			mura.chord.scroll_last = w->swc;
-			mura.chord.scroll_last_geo = geometry;
-			mura.chord.scroll_last_step = step;
+	if (wl_list_empty(&mura.wlist.clients)) {
+		wl_list_for_each(w, &mura.windows, link) {
+			if (w->dirty) {
+				wl_list_remove(&w->dirty_link);
+				w->dirty = 0;
+			}
+			w->listed = wlist_listable(w);
+			if (w->listed)
+				wlist_update(w);
 		}
-		swc_window_set_position(w->swc, geometry.x + step_x, geometry.y + step);
+		mura.wlist.nclosed = 0;
+		mura.wlist.sent_focus = camera_focus();
+		mura.wlist.sent_x = mura.camera.x;
+		mura.wlist.sent_y = mura.camera.y;
+		wlist_view(&mura.wlist.view_x, &mura.wlist.view_y,
+		           &mura.wlist.view_width, &mura.wlist.view_height);
 	}
+	wl_list_insert(&mura.wlist.clients, wl_resource_get_link(resource));
 
-	mura.chord.scroll_pending_px -= step;
-	mura.chord.scroll_pending_px_x -= step_x;
-	wl_event_source_timer_update(mura.chord.scroll_timer, timerms);
-	return 0;
+	wl_list_for_each(w, &mura.windows, link) {
+		if (w->listed)
+			wlist_send(resource, w, WLIST_ALL, true);
+	}
+	mura_windows_send_focus(resource, mura.wlist.sent_focus);
+	wlist_send_camera(resource);
+	wlist_send_view(resource);
+	mura_windows_send_done(resource);
 }
 
-static int
-scroll_drag_tick(void *data)
+/* buckets go out in chunks that stay well below the wire's message size */
+static void
+stat_send_hist(struct wl_resource *resource, const char *name, const struct hist *h)
 {
-	int32_t x, y;
-	int32_t delta_x, delta_y;
+	uint32_t chunk[2 * 256];
+	struct wl_array array;
+	size_t n = 0;
 
-	(void)data;
+	mura_stat_send_histogram(resource, name, saturate(h->count),
+	                         saturate(h->count ? h->total / h->count : 0), saturate(h->max));
 
-	if (!mura.chord.scrolling) {
-		return 0;
+	for (uint32_t i = 0; i < HIST_BUCKETS; i++) {
+		if (!h->buckets[i])
+			continue;
+		chunk[n++] = i;
+		chunk[n++] = saturate(h->buckets[i]);
+		if (n == sizeof(chunk) / sizeof(chunk[0])) {
+			array.size = array.alloc = n * sizeof(chunk[0]);
+			array.data = chunk;
+			mura_stat_send_buckets(resource, &array);
+			n = 0;
+		}
 	}
-
-	if (!cursor_position(&x, &y)) {
-		wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
-		return 0;
+	if (n) {
+		array.size = array.alloc = n * sizeof(chunk[0]);
+		array.data = chunk;
+		mura_stat_send_buckets(resource, &array);
 	}
+}
 
-	delta_x = x - mura.chord.scroll_drag_last_x;
-	delta_y = y - mura.chord.scroll_drag_last_y;
-	mura.chord.scroll_drag_last_x = x;
-	mura.chord.scroll_drag_last_y = y;
+static void
+stat_send_table(struct wl_resource *resource, struct prof_table *t, bool reset)
+{
+	for (int i = 0; i <= PROF_SLOTS; i++) {
+		struct prof_slot *slot = i < PROF_SLOTS ? &t->slots[i] : &t->other;
 
-	if (delta_x == 0 && delta_y == 0) {
-		wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
-		return 0;
+		if (!slot->hist.count)
+			continue;
+		stat_send_hist(resource, slot->name, &slot->hist);
+		if (reset)
+			memset(&slot->hist, 0, sizeof(slot->hist));
 	}
+}
 
-	/* invert */
-	mura.chord.scroll_pending_px -= delta_y;
-	mura.chord.scroll_pending_px_x -= delta_x;
+static void
+stat_snapshot(struct wl_client *client, struct wl_resource *resource, uint32_t reset)
+{
+	(void)client;
 
-	/* update cursor direction based on drag direction */
-	if (delta_y != 0) {
-		mura.chord.scroll_cursor_dir = delta_y > 0 ? 1 : -1;
-		update_mode_cursor();
+	for (int i = 0; i < PERF_COUNT; i++) {
+		stat_send_hist(resource, perf[i].name, &perf[i].hist);
+		if (reset)
+			memset(&perf[i].hist, 0, sizeof(perf[i].hist));
 	}
-
-	if (!mura.chord.scroll_timer)
-		mura.chord.scroll_timer = wl_event_loop_add_timer(mura.evloop, scroll_tick, NULL);
-	if (mura.chord.scroll_timer)
-		wl_event_source_timer_update(mura.chord.scroll_timer, 1);
-
-	wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
-	return 0;
+	stat_send_table(resource, &prof_requests, reset);
+	stat_send_table(resource, &prof_clients, reset);
+	if (reset)
+		mura.pool.hits = mura.pool.misses = 0;
+	mura_stat_send_done(resource);
 }
 
 static void
-axis(void *data, uint32_t time, uint32_t axis, int32_t value120)
+stat_destroy(struct wl_client *client, struct wl_resource *resource)
 {
-	(void)data;
+	(void)client;
+	wl_resource_destroy(resource);
+}
 
-	/* while moving a window swallow scroll events so they don't reach clients */
-	if (mura.chord.moving)
-		return;
+static const struct mura_stat_interface stat_implementation = {
+	.destroy = stat_destroy,
+	.snapshot = stat_snapshot,
+};
 
-	/* in drag scroll mode, scroll wheel controls zoom when scrolling active */
-	if (scroll_drag_mode) {
-		if (enable_zoom && mura.chord.scrolling && axis == 0 && value120 != 0) {
-			/* vertical scroll wheel controls zoom with easing */
-			if (mura.chord.zoom_target == 0)
-				mura.chord.zoom_target = swc_get_zoom();
-			float delta = (value120 < 0) ? 0.15f : -0.15f;
-			mura.chord.zoom_target += delta;
-			if (mura.chord.zoom_target < 0.25f) mura.chord.zoom_target = 0.25f;
-			if (mura.chord.zoom_target > 4.0f) mura.chord.zoom_target = 4.0f;
+static void
+bind_stat(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	struct wl_resource *resource;
 
-			/* Start or continue zoom animation */
-			if (!mura.chord.zoom_timer)
-				mura.chord.zoom_timer = wl_event_loop_add_timer(mura.evloop, zoom_tick, NULL);
-			if (mura.chord.zoom_timer)
-				wl_event_source_timer_update(mura.chord.zoom_timer, 1);
-			return;
-		}
-		swc_pointer_send_axis(time, axis, value120);
-		return;
-	}
+	(void)data;
+	if (version > 1)
+		version = 1;
 
-	if (!mura.chord.scrolling) {
-		swc_pointer_send_axis(time, axis, value120);
+	resource = wl_resource_create(client, &mura_stat_interface, version, id);
+	if (!resource) {
+		wl_client_post_no_memory(client);
 		return;
 	}
+	wl_resource_set_implementation(resource, &stat_implementation, NULL, NULL);
+}
 
-	/* only handle vertical scroll */
-	if (axis != 0 || value120 == 0) {
-		swc_pointer_send_axis(time, axis, value120);
+static void
+focus_window(struct swc_window *swc, const char *reason)
+{
+	if(mura.focused == swc)
 		return;
+	TRACE(TRACE_FOCUS, trace_string(reason), now_nsec(), 0,
+	      trace_window(mura.focused), trace_window(swc));
+
+	if(mura.focused)
+		swc_window_set_border(mura.focused, inner_border_color_inactive, inner_border_width, outer_border_color_inactive, outer_border_width);
+
+	swc_window_focus(swc);
+
+	/* zoom to default size when focusing a window */
+	if (enable_zoom && swc && swc_get_zoom() != 1.0f) {
+		mura.chord.zoom_target = 1.0f;
+		if (!mura.chord.zoom_timer)
+			mura.chord.zoom_timer = add_timer(PERF_ZOOM_TICK);
+		if (mura.chord.zoom_timer)
+			wl_event_source_timer_update(mura.chord.zoom_timer, 1);
 	}
 
-	mura.chord.scroll_cursor_dir = value120 < 0 ? -1 : 1;
-	update_mode_cursor();
+	if(swc)
+		swc_window_set_border(swc, inner_border_color_active, inner_border_width, outer_border_color_active, outer_border_width);
 
-	/* convert scroll wheel to viewport scroll */
-	int32_t dy = value120 * scrollpx / 120;
-	mura.chord.scroll_pending_px += dy;
+	mura.focused = swc;
+	camera_changed();
 
-	if (!mura.chord.scroll_timer)
-		mura.chord.scroll_timer = wl_event_loop_add_timer(mura.evloop, scroll_tick, NULL);
-	if (mura.chord.scroll_timer)
-		wl_event_source_timer_update(mura.chord.scroll_timer, 1);
-}
+	/* center the focused window: both axes in drag mode, vertical only in scroll wheel mode, only when visible or jumping to it, else you can center offscreen windows */
+	if (focus_center == true && swc && mura.current_screen && (is_visible(mura.focused, mura.current_screen) || mura.chord.jumping == true)) {
+		struct swc_rectangle window_geom;
 
-static void
-windowdestroy(void *data)
-{
-	struct window *w = data;
+		if (swc_window_get_geometry(swc, &window_geom)) {
+			/* skip if window has no size yet (not configured by client) */
+			if (window_geom.width == 0 || window_geom.height == 0)
+				return;
 
-	/* cleanup for term spawn*/
-	if (w->spawn_parent) {
-		struct window *terminal = w->spawn_parent;
+			int32_t window_center_x = window_geom.x + (int32_t)window_geom.width / 2;
+			int32_t window_center_y = window_geom.y + (int32_t)window_geom.height / 2;
+			int32_t screen_center_x = mura.current_screen->swc->geometry.x + (int32_t)mura.current_screen->swc->geometry.width / 2;
+			int32_t screen_center_y = mura.current_screen->swc->geometry.y + (int32_t)mura.current_screen->swc->geometry.height / 2;
 
-		wl_list_remove(&w->spawn_link);
+			/* in drag mode: center on both axes; in scroll wheel mode: vertical only */
+			int32_t scroll_delta_x = scroll_drag_mode ? (screen_center_x - window_center_x) : 0;
+			int32_t scroll_delta_y = screen_center_y - window_center_y;
 
-		if (wl_list_empty(&terminal->spawn_children) && terminal->hidden_for_spawn) {
-			/* restore term */
-			swc_window_show(terminal->swc);
-			swc_window_set_geometry(terminal->swc, &terminal->saved_geometry);
-			terminal->hidden_for_spawn = false;
+			if (scroll_delta_x != 0 || scroll_delta_y != 0) {
+				/* stop scroll before auto-scroll */
+				scroll_stop();
 
-			/* focus terminal */
-			focus_window(terminal->swc, "spawn_child_destroyed");
-		}
-	}
+				mura.chord.scroll_pending_px = scroll_delta_y;
+				mura.chord.scroll_pending_px_x = scroll_delta_x;
+				mura.chord.scroll_rem = 0;
+				mura.chord.scroll_rem_x = 0;
+				mura.chord.auto_scrolling = true;
+				mura.chord.centre_start = now_nsec();
 
-	if (!wl_list_empty(&w->spawn_children)) {
-		struct window *child, *tmp;
-		wl_list_for_each_safe(child, tmp, &w->spawn_children, spawn_link) {
-			child->spawn_parent = NULL;
-			wl_list_remove(&child->spawn_link);
-			wl_list_init(&child->spawn_link);
+				if (!mura.chord.scroll_timer) {
+					mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+				}
+				wl_event_source_timer_update(mura.chord.scroll_timer, timerms);
+			}
 		}
 	}
-
-	if (mura.chord.scroll_last == w->swc)
-		mura.chord.scroll_last = NULL;
-	if(mura.focused == w->swc)
-		focus_window(NULL, "destroy");
-	wl_list_remove(&w->link);
-	free(w);
 }
 
 static void
-windowappidchanged(void *data)
+top_snapshot(struct wl_client *client, struct wl_resource *resource)
 {
-	struct window *w = data;
-	struct swc_rectangle geometry;
-	bool is_select = mura.chord.spawn.pending
-	              && w->swc->app_id
-	              && strcmp(w->swc->app_id, select_term_app_id) == 0;
+	struct swc_rectangle geom;
+	struct window *w;
 
-	if(!is_select)
-		return;
+	(void)client;
+	wl_list_for_each(w, &mura.windows, link) {
+		struct surface_stat *s = w->stat;
+		uint32_t width = 0, height = 0, format = 0, pending = 0, buffers = 0;
+		uint64_t bytes = 0;
 
-	geometry = mura.chord.spawn.geometry;
-	if(geometry.width < 50)
-		geometry.width = 50;
-	if(geometry.height < 50)
-		geometry.height = 50;
-	swc_window_set_geometry(w->swc, &geometry);
-	mura.chord.spawn.pending = false;
+		if (!w->swc || w->pooled)
+			continue;
+		if (s) {
+			width = s->width;
+			height = s->height;
+			format = s->format;
+			bytes = s->bytes;
+			/* gpu buffers are guessed at 4 bytes a pixel of the window */
+			if (format == TELE_FORMAT_GPU && swc_window_get_geometry(w->swc, &geom)) {
+				width = geom.width;
+				height = geom.height;
+				bytes = (uint64_t)width * height * 4;
+			}
+			for (int i = 0; i < TELE_FRAMES; i++)
+				pending += s->watches[i].surface != NULL;
+			for (int i = 0; i < TELE_BUFFERS; i++)
+				buffers += s->buffers[i] != NULL;
+		}
+		mura_top_send_window(resource, w->id, w->pid, w->swc->app_id, w->swc->title,
+		                     s ? s->commits : 0, s ? s->frames : 0, pending,
+		                     s ? (uint32_t)(s->damage / 1000) : 0, width, height, format,
+		                     saturate(bytes * buffers / 1024));
+	}
+	mura_top_send_done(resource);
 }
 
-static const struct swc_window_handler windowhandler = {
-	.destroy = windowdestroy,
-	.app_id_changed = windowappidchanged,
-};
+/* like the jump chord, centre it even when it is off screen */
+static void
+jump_to(struct window *w, const char *reason)
+{
+	bool centre = focus_center;
+
+	focus_center = true;
+	mura.chord.jumping = true;
+	focus_window(w->swc, reason);
+	mura.chord.jumping = false;
+	focus_center = centre;
+}
 
 static void
-screendestroy(void *data)
+top_focus(struct wl_client *client, struct wl_resource *resource, uint32_t id)
 {
-	struct screen *s = data;
-	wl_list_remove(&s->link);
-	free(s);
+	struct window *w;
+
+	(void)client;
+	(void)resource;
+	wl_list_for_each(w, &mura.windows, link) {
+		if (w->id != id)
+			continue;
+		if (!w->swc || w->pooled || w->map_pending)
+			return;
+		jump_to(w, "mura-top");
+		return;
+	}
 }
 
-static const struct swc_screen_handler screenhandler = {
-	.destroy = screendestroy,
+static void
+top_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	(void)client;
+	wl_resource_destroy(resource);
+}
+
+static const struct mura_top_interface top_implementation = {
+	.destroy = top_destroy,
+	.snapshot = top_snapshot,
+	.focus = top_focus,
 };
 
 static void
-newscreen(struct swc_screen *swc)
+bind_top(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 {
-	struct screen *s;
+	struct wl_resource *resource;
 
-	s = malloc(sizeof(*s));
-	if(!s)
+	(void)data;
+	if (version > 1)
+		version = 1;
+
+	resource = wl_resource_create(client, &mura_top_interface, version, id);
+	if (!resource) {
+		wl_client_post_no_memory(client);
 		return;
-	s->swc = swc;
-	wl_list_insert(&mura.screens, &s->link);
-	swc_screen_set_handler(swc, &screenhandler, s);
-	printf("screen %dx%d\n", swc->geometry.width, swc->geometry.height);
+	}
+	wl_resource_set_implementation(resource, &top_implementation, NULL, NULL);
+}
 
-	if (!mura.chord.cursor_timer)
-		mura.chord.cursor_timer = wl_event_loop_add_timer(mura.evloop, cursor_tick, NULL);
-	if (mura.chord.cursor_timer)
-		wl_event_source_timer_update(mura.chord.cursor_timer, timerms);
+static bool
+cursor_position_raw(int32_t *x, int32_t *y)
+{
+	int32_t fx, fy;
+
+	/* a replay owns the cursor path */
+	if (mura.input.replaying) {
+		*x = mura.input.x;
+		*y = mura.input.y;
+		return true;
+	}
+
+	if(!swc_cursor_position(&fx, &fy))
+		return false;
+	*x = wl_fixed_to_int(fx);
+	*y = wl_fixed_to_int(fy);
+	return true;
 }
 
-/* helpers for pid*/
-static pid_t
-get_parent_pid(pid_t pid)
+static void
+input_record(uint16_t type, uint16_t code, int32_t a, int32_t b)
 {
-	char path[64];
-	FILE *f;
-	pid_t parent_pid = 0;
+	struct input_event ev;
 
-	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
-	f = fopen(path, "r");
-	if (!f)
-		return 0;
+	if (!mura.input.record)
+		return;
 
-	/* its like: pid (comm) state ppid ... */
-	fscanf(f, "%*d %*s %*c %d", &parent_pid);
-	fclose(f);
-	return parent_pid;
+	ev.msec = (uint32_t)((now_nsec() - mura.input.record_start) / 1000000);
+	ev.type = type;
+	ev.code = code;
+	ev.a = a;
+	ev.b = b;
+	fwrite(&ev, sizeof(ev), 1, mura.input.record);
 }
 
-static struct window *
-find_window_by_pid(pid_t pid)
+/* only positions that differ from the last one recorded make it into the trace */
+static void
+input_record_motion(void)
 {
-	struct window *w;
+	int32_t x, y;
 
-	wl_list_for_each(w, &mura.windows, link) {
-		if (w->pid == pid)
-			return w;
-	}
-	return NULL;
+	if (!mura.input.record || !cursor_position_raw(&x, &y))
+		return;
+	if (x == mura.input.record_x && y == mura.input.record_y)
+		return;
+
+	mura.input.record_x = x;
+	mura.input.record_y = y;
+	input_record(INPUT_MOTION, 0, x, y);
 }
 
 static bool
-is_terminal_window(struct window *w)
+cursor_position(int32_t *x, int32_t *y)
 {
-	if (!w || !w->swc)
+	if(!cursor_position_raw(x, y))
 		return false;
 
-	/* check app_id */
-	if (w->swc->app_id) {
-		for (const char *const *term = terminal_app_ids; *term; term++) {
-			if (strstr(w->swc->app_id, *term))
-				return true;
+	if (enable_zoom) {
+		float zoom = swc_get_zoom();
+		if (zoom != 1.0f && mura.current_screen) {
+			int32_t cx = mura.current_screen->swc->geometry.x + mura.current_screen->swc->geometry.width / 2;
+			int32_t cy = mura.current_screen->swc->geometry.y + mura.current_screen->swc->geometry.height / 2;
+			*x = (int32_t)((*x - cx) / zoom) + cx;
+			*y = (int32_t)((*y - cy) / zoom) + cy;
 		}
 	}
 
-	/* check title too, because, paranoia */
-	if (w->swc->title) {
-		for (const char *const *term = terminal_app_ids; *term; term++) {
-			if (strstr(w->swc->title, *term))
-				return true;
+	return true;
+}
+
+/* hacky sorta, only works for vertical cuz of this */
+static bool
+is_on_screen(struct swc_rectangle *window, struct screen *screen)
+{
+	struct swc_rectangle *geom = &screen->swc->geometry;
+
+	return window->x + (int32_t)window->width > geom->x && window->x < geom->x + (int32_t)geom->width;
+}
+
+static bool
+is_visible(struct swc_window *w, struct screen *screen)
+{
+	struct swc_rectangle *geom = &screen->swc->geometry;
+	struct swc_rectangle wgeom;
+	swc_window_get_geometry(w, &wgeom);
+
+	bool h = wgeom.x + (int32_t)wgeom.width > geom->x && wgeom.x < geom->x + (int32_t)geom->width;
+	bool v = wgeom.y + (int32_t)wgeom.height > geom->y && wgeom.y < geom->y + (int32_t)geom->height;
+
+	return h && v;
+}
+
+static void
+world_to_screen(int32_t wx, int32_t wy, int32_t *sx, int32_t *sy)
+{
+	if (enable_zoom) {
+		float zoom = swc_get_zoom();
+		if (zoom != 1.0f && mura.current_screen) {
+			int32_t cx = mura.current_screen->swc->geometry.x + mura.current_screen->swc->geometry.width / 2;
+			int32_t cy = mura.current_screen->swc->geometry.y + mura.current_screen->swc->geometry.height / 2;
+			*sx = (int32_t)((wx - cx) * zoom) + cx;
+			*sy = (int32_t)((wy - cy) * zoom) + cy;
+			return;
 		}
 	}
+	*sx = wx;
+	*sy = wy;
+}
 
-	return false;
+static bool
+is_acme(const struct swc_window *swc)
+{
+	return swc && swc->app_id && strcmp(swc->app_id, "acme") == 0;
 }
 
 static void
-mk_spawn_link(struct window *terminal, struct window *child)
+update_mode_cursor(void)
 {
-	child->spawn_parent = terminal;
-	wl_list_insert(&terminal->spawn_children, &child->spawn_link);
-
-	/* save term geom */
-	if (swc_window_get_geometry(terminal->swc, &terminal->saved_geometry)) {
-		terminal->hidden_for_spawn = true;
-		swc_window_hide(terminal->swc);
-		swc_window_set_geometry(child->swc, &terminal->saved_geometry);
+	if (mura.chord.killing)
+		swc_set_cursor(SWC_CURSOR_SIGHT);
+	else if (mura.chord.scrolling) {
+		if (mura.chord.scroll_cursor_dir < 0)
+			swc_set_cursor(SWC_CURSOR_UP);
+		else
+			swc_set_cursor(SWC_CURSOR_DOWN);
 	}
+	else if (mura.chord.selecting)
+		swc_set_cursor(SWC_CURSOR_CROSS);
+	else if (mura.chord.moving || mura.chord.resize)
+		swc_set_cursor(SWC_CURSOR_BOX);
+	else
+		swc_set_cursor(SWC_CURSOR_DEFAULT);
 }
 
 static void
-newwindow(struct swc_window *swc)
+maybe_enable_nein_cursor_theme(void)
 {
-	struct window *w;
-	struct swc_rectangle geometry;
-	bool is_select = mura.chord.spawn.pending
-	              && swc->app_id
-	              && strcmp(swc->app_id, select_term_app_id) == 0;
+	const struct nein_cursor_meta *arrow = &nein_cursor_metadata[NEIN_CURSOR_WHITEARROW];
+	const struct nein_cursor_meta *box = &nein_cursor_metadata[NEIN_CURSOR_BOXCURSOR];
+	const struct nein_cursor_meta *cross = &nein_cursor_metadata[NEIN_CURSOR_CROSSCURSOR];
+	const struct nein_cursor_meta *sight = &nein_cursor_metadata[NEIN_CURSOR_SIGHTCURSOR];
+	const struct nein_cursor_meta *up = &nein_cursor_metadata[NEIN_CURSOR_T];
+	const struct nein_cursor_meta *down = &nein_cursor_metadata[NEIN_CURSOR_B];
 
-	w = malloc(sizeof(*w));
-	if(!w)
+	if (!cursor_theme || strcmp(cursor_theme, "nein") != 0)
 		return;
-	w->swc = swc;
-	w->pid = 0;
-	w->spawn_parent = NULL;
-	wl_list_init(&w->spawn_children);
-	wl_list_init(&w->spawn_link);
-	w->hidden_for_spawn = false;
-	w->sticky = false;
 
-	wl_list_insert(&mura.windows, &w->link);
-	swc_window_set_handler(swc, &windowhandler, w);
-	swc_window_set_stacked(swc);
-	swc_window_set_border(swc, inner_border_color_inactive, inner_border_width, outer_border_color_inactive, outer_border_width);
+	swc_set_cursor_mode(SWC_CURSOR_MODE_COMPOSITOR);
+	swc_set_cursor_image(SWC_CURSOR_DEFAULT, &nein_cursor_data[arrow->offset],
+	                     arrow->width, arrow->height,
+	                     arrow->hotspot_x, arrow->hotspot_y);
+	swc_set_cursor_image(SWC_CURSOR_BOX, &nein_cursor_data[box->offset],
+	                     box->width, box->height,
+	                     box->hotspot_x, box->hotspot_y);
+	swc_set_cursor_image(SWC_CURSOR_CROSS, &nein_cursor_data[cross->offset],
+	                     cross->width, cross->height,
+	                     cross->hotspot_x, cross->hotspot_y);
+	swc_set_cursor_image(SWC_CURSOR_SIGHT, &nein_cursor_data[sight->offset],
+	                     sight->width, sight->height,
+	                     sight->hotspot_x, sight->hotspot_y);
+	swc_set_cursor_image(SWC_CURSOR_UP, &nein_cursor_data[up->offset],
+	                     up->width, up->height,
+	                     up->hotspot_x, up->hotspot_y);
+	swc_set_cursor_image(SWC_CURSOR_DOWN, &nein_cursor_data[down->offset],
+	                     down->width, down->height,
+	                     down->hotspot_x, down->hotspot_y);
 
-	/* get pid and check conf for term spawn */
-	if (enable_terminal_spawning) {
-		w->pid = swc_window_get_pid(swc);
+	update_mode_cursor();
+}
 
-		if (w->pid > 0) {
-			/* im so fucking dumb, we need to walk up the proc tree to get the term, otherwise we just get the shell */
-			pid_t current_pid = w->pid;
-			struct window *terminal = NULL;
-			int depth = 0;
+static void
+stop_select(void)
+{
+	if(mura.chord.timer){
+		wl_event_source_remove(mura.chord.timer);
+		mura.chord.timer = NULL;
+	}
+	mura.chord.selecting = false;
+	swc_overlay_clear();
+	update_mode_cursor();
+}
 
-			/* walk up 10 levels */
-			while (depth < 10 && current_pid > 1) {
-				pid_t parent_pid = get_parent_pid(current_pid);
-				if (parent_pid <= 1)
-					break;
+static int scroll_tick(void *data);
 
-				/* check pid against term*/
-				struct window *candidate = find_window_by_pid(parent_pid);
-				if (candidate && is_terminal_window(candidate)) {
-					terminal = candidate;
-					break;
-				}
+static int
+select_tick(void *data)
+{
+	int32_t x, y;
 
-				current_pid = parent_pid;
-				depth++;
-			}
+	(void)data;
+	if(!mura.chord.selecting)
+		return 0;
 
-			if (terminal)
-				mk_spawn_link(terminal, w);
-		}
+	if(cursor_position(&x, &y)){
+		mura.chord.cur_x = x;
+		mura.chord.cur_y = y;
+		swc_overlay_set_box(mura.chord.start_x, mura.chord.start_y, x, y,
+		                    select_box_color, select_box_border);
 	}
 
-	if(is_select){
-		geometry = mura.chord.spawn.geometry;
-		if(geometry.width < 50)
-			geometry.width = 50;
-		if(geometry.height < 50)
-			geometry.height = 50;
-		swc_window_set_geometry(swc, &geometry);
-		mura.chord.spawn.pending = false;
-	}
-	swc_window_show(swc);
-	printf("window '%s'\n", swc->title ? swc->title : "");
-	focus_window(swc, "new_window");
+	wl_event_source_timer_update(mura.chord.timer, timerms);
+	return 0;
 }
 
-static void
-newdevice(struct libinput_device *dev)
+static int
+move_scroll_tick(void *data)
 {
-	(void)dev;
-}
-
+	int32_t x, y;
+	struct swc_rectangle geometry;
+	int32_t screen_height = 0;
+
+	(void)data;
+	if(!mura.chord.moving)
+		return 0;
+
+	/* get screen size*/
+	if(mura.current_screen){
+		screen_height = mura.current_screen->swc->geometry.height;
+	}
+
+	if(screen_height == 0){
+		wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
+		return 0;
+	}
+
+	if(!cursor_position(&x, &y)){
+		wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
+		return 0;
+	}
+
+	/* get where the where the window starts [line 558], every 16ms calculate where it should be
+	 * then move only <config-value>% of that gap, then next frame, move
+	 * <config-value>% of the new, smaller gap, exponential easing*/
+	if(mura.focused && swc_window_get_geometry(mura.focused, &geometry)){
+		int32_t target_x = mura.chord.move_start_win_x + (x - mura.chord.move_start_cursor_x);
+		int32_t target_y = mura.chord.move_start_win_y + (y - mura.chord.move_start_cursor_y);
+		int32_t new_x = geometry.x + (int32_t)((target_x - geometry.x) * move_ease_factor);
+		int32_t new_y = geometry.y + (int32_t)((target_y - geometry.y) * move_ease_factor);
+		swc_window_set_position(mura.focused, new_x, new_y);
+		wlist_moved(mura.focused);
+	}
+
+	/* check near top bottom and scroll accordingly */
+	if(y < move_scroll_edge_threshold){
+		mura.chord.scroll_pending_px += move_scroll_speed;
+		if(!mura.chord.scroll_timer)
+			mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+		if(mura.chord.scroll_timer)
+			wl_event_source_timer_update(mura.chord.scroll_timer, 1);
+	} else if(y > screen_height - move_scroll_edge_threshold){
+		mura.chord.scroll_pending_px -= move_scroll_speed;
+		if(!mura.chord.scroll_timer)
+			mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+		if(mura.chord.scroll_timer)
+			wl_event_source_timer_update(mura.chord.scroll_timer, 1);
+	}
+
+	wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
+	return 0;
+}
+
+static struct spawn_entry *
+spawn_find(uint32_t token)
+{
+	struct spawn_entry *e;
+
+	wl_list_for_each(e, &mura.spawns, link) {
+		if (e->token == token)
+			return e;
+	}
+	return NULL;
+}
+
+static void
+spawn_remove(struct spawn_entry *e)
+{
+	wl_list_remove(&e->link);
+	free(e);
+}
+
+static void
+spawner_stop(void)
+{
+	if (mura.spawner.source)
+		wl_event_source_remove(mura.spawner.source);
+	mura.spawner.source = NULL;
+	close(mura.spawner.fd);
+	mura.spawner.fd = -1;
+}
+
+/* requests the helper had no room for wait in spawner.c, and the socket
+ * is watched for room until they are sent */
+static void
+spawner_watch(void)
+{
+	if (mura.spawner.source)
+		wl_event_source_fd_update(mura.spawner.source, spawn_pending() ?
+		                          WL_EVENT_READABLE | WL_EVENT_WRITABLE : WL_EVENT_READABLE);
+}
+
+static int
+spawner_dispatch(int fd, uint32_t mask, void *data)
+{
+	struct spawn_event ev;
+	struct spawn_entry *e;
+	uint64_t start = perf_start();
+
+	(void)data;
+
+	if ((mask & WL_EVENT_WRITABLE) && !spawn_flush(fd))
+		mask |= WL_EVENT_HANGUP;
+
+	while (spawn_read_event(fd, &ev)) {
+		e = spawn_find(ev.token);
+
+		switch (ev.type) {
+		case SPAWN_FAILED:
+			fprintf(stderr, "cannot spawn: %s\n", strerror(ev.status));
+			/* fall through */
+		case SPAWN_EXITED:
+			/* gone before it opened a window, pool terminals are not retried */
+			if (e && !e->window)
+				spawn_remove(e);
+			break;
+		case SPAWN_STARTED:
+			if (e)
+				e->pid = ev.pid;
+			break;
+		case SPAWN_PARENT:
+			proc_add(ev.pid, ev.status);
+			break;
+		case SPAWN_PARENTS_DONE:
+			swallow_answered(ev.pid);
+			break;
+		case SPAWN_TOKEN:
+			spawn_token_answered(ev.pid, ev.token);
+			break;
+		}
+	}
+
+	if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+		fprintf(stderr, "spawn helper went away\n");
+		spawner_stop();
+		if (spawn_pending())
+			spawner_start();
+	} else {
+		spawner_watch();
+	}
+	perf_add(PERF_SPAWNER, start);
+	return 0;
+}
+
+static bool
+spawner_start(void)
+{
+	mura.spawner.fd = spawn_helper_start();
+	if (mura.spawner.fd < 0) {
+		fprintf(stderr, "cannot start spawn helper\n");
+		return false;
+	}
+	if (mura.evloop) {
+		mura.spawner.source = wl_event_loop_add_fd(mura.evloop, mura.spawner.fd,
+		                                           WL_EVENT_READABLE, spawner_dispatch, NULL);
+		spawner_watch();
+	}
+	return true;
+}
+
+/* children start from the helper forked at startup, so the cost here is one
+ * message no matter how much memory mura has mapped. a busy helper gets the
+ * message later, it only forks again if it died. returns the token its events
+ * will carry, 0 on failure */
+static uint32_t
+spawn(char *const argv[])
+{
+	char wayland_display[128], display[128], ctl[128], token_env[32];
+	char *env[5] = { NULL };
+	const char *v;
+	uint32_t token;
+	uint64_t start = now_nsec();
+	int n = 0;
+
+	/* the helper predates both of these */
+	if ((v = getenv("WAYLAND_DISPLAY"))) {
+		snprintf(wayland_display, sizeof(wayland_display), "WAYLAND_DISPLAY=%s", v);
+		env[n++] = wayland_display;
+	}
+	if ((v = getenv("DISPLAY"))) {
+		snprintf(display, sizeof(display), "DISPLAY=%s", v);
+		env[n++] = display;
+	}
+	if ((v = getenv("MURA_CTL"))) {
+		snprintf(ctl, sizeof(ctl), "MURA_CTL=%s", v);
+		env[n++] = ctl;
+	}
+
+	/* lets windows of wrapped commands find their way back to the entry */
+	token = ++mura.spawner.next_token;
+	snprintf(token_env, sizeof(token_env), "MURA_SPAWN_TOKEN=%" PRIu32, token);
+	env[n++] = token_env;
+
+	if (mura.spawner.fd < 0 && !spawner_start())
+		return 0;
+	if (!spawn_request(mura.spawner.fd, token, argv, env)) {
+		if (errno == E2BIG) {
+			fprintf(stderr, "cannot spawn %s: %s\n", argv[0], strerror(errno));
+			return 0;
+		}
+		spawner_stop();
+		if (!spawner_start() || !spawn_request(mura.spawner.fd, token, argv, env))
+			return 0;
+	}
+	spawner_watch();
+
+	perf_add(PERF_SPAWN, start);
+	return token;
+}
+
+static int
+spawn_expire_tick(void *data)
+{
+	struct spawn_entry *e, *tmp;
+	uint64_t now = now_nsec();
+	bool waiting = false;
+
+	(void)data;
+
+	/* a selection whose terminal never showed up stops holding its geometry */
+	wl_list_for_each_safe(e, tmp, &mura.spawns, link) {
+		if (e->kind != SPAWN_FOR_SELECT)
+			continue;
+		if (now - e->start > (uint64_t)spawn_timeout_ms * 1000000)
+			spawn_remove(e);
+		else
+			waiting = true;
+	}
+
+	if (waiting)
+		wl_event_source_timer_update(mura.spawn_timer, 1000);
+	return 0;
+}
+
+static bool
+term_sized_spawn(void)
+{
+	return term_geometry_args[0] != NULL && term_cell_width > 0 && term_cell_height > 0;
+}
+
+/* the terminal draws whole cells, so a selection is shrunk to the size the
+ * terminal will pick for it and never needs a second layout */
+static void
+term_snap_geometry(struct swc_rectangle *geometry, uint32_t *cols, uint32_t *rows)
+{
+	uint32_t pad = 2 * term_padding;
+
+	*cols = geometry->width > pad + term_cell_width ? (geometry->width - pad) / term_cell_width : 1;
+	*rows = geometry->height > pad + term_cell_height ? (geometry->height - pad) / term_cell_height : 1;
+	while (*cols * term_cell_width + pad < 50)
+		(*cols)++;
+	while (*rows * term_cell_height + pad < 50)
+		(*rows)++;
+
+	geometry->width = *cols * term_cell_width + pad;
+	geometry->height = *rows * term_cell_height + pad;
+}
+
+/* expand %c and %r in a term_geometry_args entry */
+static void
+term_geometry_arg(char *buf, size_t len, const char *fmt, uint32_t cols, uint32_t rows)
+{
+	size_t n = 0;
+
+	for (; *fmt && n + 1 < len; fmt++) {
+		if (fmt[0] == '%' && (fmt[1] == 'c' || fmt[1] == 'r')) {
+			int w = snprintf(buf + n, len - n, "%" PRIu32, *++fmt == 'c' ? cols : rows);
+
+			if (w < 0 || (size_t)w >= len - n)
+				break;
+			n += (size_t)w;
+		} else {
+			buf[n++] = *fmt;
+		}
+	}
+	buf[n] = '\0';
+}
+
+static struct spawn_entry *
+spawn_term(enum spawn_kind kind, struct swc_rectangle *geometry)
+{
+	char *argv[16] = { (char *)term, (char *)term_flag, (char *)select_term_app_id };
+	char args[8][32];
+	struct spawn_entry *e;
+	uint32_t cols, rows;
+	int argc = 3, i;
+
+	if (geometry && term_sized_spawn()) {
+		term_snap_geometry(geometry, &cols, &rows);
+		for (i = 0; i < 8 && term_geometry_args[i]; i++) {
+			term_geometry_arg(args[i], sizeof(args[i]), term_geometry_args[i], cols, rows);
+			argv[argc++] = args[i];
+		}
+	}
+	argv[argc] = NULL;
+
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		return NULL;
+	e->kind = kind;
+	e->start = now_nsec();
+	if (geometry)
+		e->geometry = *geometry;
+	e->token = spawn(argv);
+	if (!e->token) {
+		free(e);
+		return NULL;
+	}
+	wl_list_insert(mura.spawns.prev, &e->link);
+
+	if (kind == SPAWN_FOR_SELECT) {
+		if (!mura.spawn_timer)
+			mura.spawn_timer = add_timer(PERF_SPAWN_EXPIRE_TICK);
+		if (mura.spawn_timer)
+			wl_event_source_timer_update(mura.spawn_timer, 1000);
+	}
+	return e;
+}
+
+/* find the spawn a new window belongs to by the pid the helper reported.
+ * a wrapped command has another pid, so the helper is asked for the token
+ * in the client's environment, and spawn_token_answered() claims it late */
+static struct spawn_entry *
+spawn_claim(struct window *w)
+{
+	struct spawn_entry *e;
+	bool waiting = false;
+
+	if (w->pid <= 0)
+		return NULL;
+
+	/* pooled terminals keep their entry, only unclaimed ones are worth
+	 * asking the helper about */
+	wl_list_for_each(e, &mura.spawns, link) {
+		if (e->window)
+			continue;
+		if (e->pid == w->pid)
+			return e;
+		waiting = true;
+	}
+
+	if (waiting && mura.spawner.fd >= 0 && spawn_request_token(mura.spawner.fd, w->pid)) {
+		spawner_watch();
+		w->token_pending = true;
+	}
+	return NULL;
+}
+
+/* top the pool back up to term_pool_size terminals, counting the ones
+ * still starting */
+static void
+pool_fill(void)
+{
+	struct spawn_entry *e;
+	int n = 0;
+
+	wl_list_for_each(e, &mura.spawns, link) {
+		if (e->kind == SPAWN_FOR_POOL)
+			n++;
+	}
+
+	for (; n < term_pool_size; n++) {
+		if (!spawn_term(SPAWN_FOR_POOL, NULL))
+			return;
+	}
+}
+
+static void
+pool_forget(struct window *w)
+{
+	struct spawn_entry *e, *tmp;
+
+	wl_list_for_each_safe(e, tmp, &mura.spawns, link) {
+		if (e->window == w)
+			spawn_remove(e);
+	}
+}
+
+static struct window *
+pool_take(void)
+{
+	struct spawn_entry *e;
+	struct window *w;
+
+	wl_list_for_each(e, &mura.spawns, link) {
+		if (e->kind != SPAWN_FOR_POOL || !e->window)
+			continue;
+		w = e->window;
+		w->pooled = false;
+		spawn_remove(e);
+		return w;
+	}
+	return NULL;
+}
+
+static void
+place_spawned(struct swc_window *swc, struct swc_rectangle geometry)
+{
+	if(geometry.width < 50)
+		geometry.width = 50;
+	if(geometry.height < 50)
+		geometry.height = 50;
+	swc_window_set_geometry(swc, &geometry);
+	wlist_moved(swc);
+}
+
+static void
+map_spawned(struct window *w)
+{
+	if (w->map_pending) {
+		w->map_pending = false;
+		mura.map_pending--;
+	}
+	swc_window_show(w->swc);
+	wlist_changed(w, WLIST_ALL);
+	focus_window(w->swc, "new_window");
+	if (w->spawn_start)
+		perf_add(PERF_SPAWN_VISIBLE, w->spawn_start);
+}
+
+/* keep w hidden until map_check() sees a buffer of width by height */
+static void
+map_defer(struct window *w, uint32_t width, uint32_t height)
+{
+	w->map_pending = true;
+	w->map_start = now_nsec();
+	w->map_width = width;
+	w->map_height = height;
+	mura.map_pending++;
+	if (!mura.map_timer)
+		mura.map_timer = add_timer(PERF_MAP_TICK);
+	if (mura.map_timer)
+		wl_event_source_timer_update(mura.map_timer, spawn_map_timeout_ms + 1);
+}
+
+/* show terminals that were started at, or pooled ones resized to, their
+ * selected size once their first buffer at that size is in, or after
+ * spawn_map_timeout_ms in case the terminal rounded differently */
+static void
+map_check(void)
+{
+	struct window *w, *tmp;
+	struct swc_rectangle geom;
+	uint64_t now;
+
+	if (mura.map_pending == 0)
+		return;
+
+	now = now_nsec();
+	wl_list_for_each_safe(w, tmp, &mura.windows, link) {
+		if (!w->map_pending)
+			continue;
+		if ((swc_window_get_geometry(w->swc, &geom) &&
+		     geom.width == w->map_width && geom.height == w->map_height) ||
+		    now - w->map_start > (uint64_t)spawn_map_timeout_ms * 1000000)
+			map_spawned(w);
+	}
+}
+
+static int
+map_tick(void *data)
+{
+	(void)data;
+	map_check();
+	return 0;
+}
+
+static void
+spawn_term_select(const struct swc_rectangle *geometry)
+{
+	struct swc_rectangle g = *geometry;
+	struct window *w;
+	uint32_t cols, rows;
+
+	/* pool terminals were started before the size was known, so a hit
+	 * still costs them one relayout, which is not shown until it is in */
+	if ((w = pool_take())) {
+		mura.pool.hits++;
+		w->spawn_start = now_nsec();
+		if (term_cell_width > 0 && term_cell_height > 0) {
+			term_snap_geometry(&g, &cols, &rows);
+			place_spawned(w->swc, g);
+			map_defer(w, g.width, g.height);
+		} else {
+			place_spawned(w->swc, g);
+			map_spawned(w);
+		}
+		pool_fill();
+		return;
+	}
+
+	if (term_pool_size > 0)
+		mura.pool.misses++;
+	spawn_term(SPAWN_FOR_SELECT, &g);
+	pool_fill();
+}
+
+static void click_cancel(void);
+
+static int
+click_timeout(void *data)
+{
+	(void)data;
+
+	if(!mura.chord.click.pending)
+		return 0;
+
+	/* don't forward clicks while move chord is active */
+	if (mura.chord.moving) {
+		click_cancel();
+		return 0;
+	}
+
+	if(mura.chord.left && mura.chord.right)
+		return 0;
+
+	if(!mura.chord.click.forwarded){
+		swc_pointer_send_button(mura.chord.click.time, mura.chord.click.button,
+		                        WL_POINTER_BUTTON_STATE_PRESSED);
+		mura.chord.click.forwarded = true;
+	}
+
+	return 0;
+}
+
+static void
+click_cancel(void)
+{
+	if(mura.chord.click_timer){
+		wl_event_source_remove(mura.chord.click_timer);
+		mura.chord.click_timer = NULL;
+	}
+	mura.chord.click.pending = false;
+	mura.chord.click.forwarded = false;
+}
+
+static void
+scroll_stop(void)
+{
+	mura.chord.scroll_pending_px = 0;
+	mura.chord.scroll_pending_px_x = 0;
+	mura.chord.scroll_rem = 0;
+	mura.chord.scroll_rem_x = 0;
+	mura.chord.auto_scrolling = false;
+	mura.chord.centre_start = 0;
+
+	/* stop drag timer */
+	if (mura.chord.scroll_drag_timer) {
+		wl_event_source_remove(mura.chord.scroll_drag_timer);
+		mura.chord.scroll_drag_timer = NULL;
+	}
+}
+
+static int
+cursor_tick(void *data)
+{
+	(void)data;
+
+	int32_t x, y;
+	struct screen *ns = NULL;
+
+	if (!cursor_position_raw(&x, &y)) {
+		wl_event_source_timer_update(mura.chord.cursor_timer, timerms);
+		return 0;
+	}
+
+	wl_list_for_each(ns, &mura.screens, link) {
+		struct swc_rectangle *geom = &ns->swc->geometry;
+
+		if(x >= geom->x && x < geom->x + (int32_t)geom->width &&
+				y >= geom->y && y < geom->y + (int32_t)geom->height) {
+
+			if(mura.current_screen != ns) {
+				mura.current_screen = ns;
+				/* the view follows the pointer's screen */
+				camera_changed();
+			}
+
+			break;
+		}
+
+	}
+
+	wl_event_source_timer_update(mura.chord.cursor_timer, timerms);
+	return 0;
+}
+
+static int
+zoom_tick(void *data)
+{
+	(void)data;
+
+	float current = swc_get_zoom();
+	float target = mura.chord.zoom_target;
+	float diff = target - current;
+
+	/* Stop if close enough */
+	if (diff > -0.01f && diff < 0.01f) {
+		swc_set_zoom(target);
+		camera_changed();
+		return 0;
+	}
+
+	/* Ease toward target */
+	float step = diff / 4.0f;
+	if (step > 0 && step < 0.01f) step = 0.01f;
+	if (step < 0 && step > -0.01f) step = -0.01f;
+
+	swc_set_zoom(current + step);
+	camera_changed();
+
+	/* Continue animation */
+	wl_event_source_timer_update(mura.chord.zoom_timer, timerms);
+	return 0;
+}
+
+/* whether a pan moves w on the screen. the rest keep their place on the
+ * screen, so they move on the plane instead */
+static bool
+pan_moves(struct window *w, struct swc_rectangle *geometry)
+{
+	if (w->sticky)
+		return false;
+
+	/* when scroll with moving window, dont scroll the moving window, it makes it all jittery and ew */
+	if (mura.chord.moving && w->swc == mura.focused)
+		return false;
+	return scroll_drag_mode || is_on_screen(geometry, mura.current_screen);
+}
+
+static void
+plane_add(const struct swc_rectangle *geometry)
+{
+	int64_t x = geometry->x - mura.camera.x, y = geometry->y - mura.camera.y;
+
+	if (mura.plane.empty) {
+		mura.plane.min_x = mura.plane.max_x = x;
+		mura.plane.min_y = mura.plane.max_y = y;
+		mura.plane.empty = false;
+		return;
+	}
+	mura.plane.min_x = x < mura.plane.min_x ? x : mura.plane.min_x;
+	mura.plane.max_x = x > mura.plane.max_x ? x : mura.plane.max_x;
+	mura.plane.min_y = y < mura.plane.min_y ? y : mura.plane.min_y;
+	mura.plane.max_y = y > mura.plane.max_y ? y : mura.plane.max_y;
+}
+
+static void
+plane_update(void)
+{
+	struct window *w;
+	struct swc_rectangle geometry;
+
+	if (!mura.plane.stale)
+		return;
+	mura.plane.empty = true;
+	mura.plane.stale = false;
+	wl_list_for_each(w, &mura.windows, link) {
+		if (w->swc && swc_window_get_geometry(w->swc, &geometry))
+			plane_add(&geometry);
+	}
+}
+
+/* move the plane under the screen right away. a pan stops where a window
+ * would leave the 32 bits of swc's positions, so the plane keeps its shape */
+static void
+pan(int32_t dx, int32_t dy)
+{
+	struct window *w, *tmp;
+	struct swc_rectangle geometry;
+	bool stale;
+
+	plane_update();
+	if (!mura.plane.empty) {
+		dx = (int32_t)clamp64(dx, clamp64(INT32_MIN - (mura.plane.min_x + mura.camera.x), INT32_MIN, 0),
+		                      clamp64(INT32_MAX - (mura.plane.max_x + mura.camera.x), 0, INT32_MAX));
+		dy = (int32_t)clamp64(dy, clamp64(INT32_MIN - (mura.plane.min_y + mura.camera.y), INT32_MIN, 0),
+		                      clamp64(INT32_MAX - (mura.plane.max_y + mura.camera.y), 0, INT32_MAX));
+	}
+	if (!dx && !dy)
+		return;
+
+	mura.camera.x += dx;
+	mura.camera.y += dy;
+	camera_changed();
+
+	/* the windows left behind are added to the bounds here, which saves
+	 * the walk their wlist_changed() would otherwise cost the next pan */
+	stale = mura.plane.stale;
+	wl_list_for_each_safe(w, tmp, &mura.windows, link) {
+		if (!w->swc) {
+			TRACE(TRACE_MARK, trace_string("scroll: window without swc"), now_nsec(), 0, 0, 0);
+			continue;
+		}
+		if (!swc_window_get_geometry(w->swc, &geometry))
+			continue;
+		if (!pan_moves(w, &geometry)) {
+			plane_add(&geometry);
+			wlist_changed(w, WLIST_GEOMETRY);
+			continue;
+		}
+		swc_window_set_position(w->swc, geometry.x + dx, geometry.y + dy);
+	}
+	mura.plane.stale = stale;
+}
+
+/* pans the camera to x, y, one 32 bit step at a time. stops short where
+ * pan() does */
+static void
+pan_to(int64_t x, int64_t y)
+{
+	int64_t dx, dy, from_x, from_y;
+
+	do {
+		dx = x - mura.camera.x;
+		dy = y - mura.camera.y;
+		if (!dx && !dy)
+			break;
+		from_x = mura.camera.x;
+		from_y = mura.camera.y;
+		pan((int32_t)clamp64(dx, INT32_MIN, INT32_MAX), (int32_t)clamp64(dy, INT32_MIN, INT32_MAX));
+	} while (mura.camera.x != from_x || mura.camera.y != from_y);
+}
+
+static int
+scroll_tick(void *data)
+{
+	int32_t rem, rem_x;
+	int32_t step, step_x;
+
+	(void)data;
+
+	/* while a window is dragged into an edge band, keep feeding the pan at
+	 * the speed the pointer's depth into the band asked for */
+	if (mura.chord.moving)
+		mura.chord.scroll_pending_px += mura.chord.move_edge_velocity;
+	rem = mura.chord.scroll_pending_px;
+	rem_x = mura.chord.scroll_pending_px_x;
+
+	if (!mura.chord.scroll_timer) {
+		TRACE(TRACE_MARK, trace_string("scroll: tick without timer"), now_nsec(), 0, 0, 0);
+		return 0;
+	}
+
+	if ((!mura.chord.scrolling && !mura.chord.auto_scrolling && !mura.chord.moving) || (rem == 0 && rem_x == 0)) {
+		if (mura.chord.centre_start && rem == 0 && rem_x == 0)
+			perf_add(PERF_FOCUS_CENTRED, mura.chord.centre_start);
+		TRACE(TRACE_MARK, trace_string("scroll: stop"), now_nsec(), 0, rem, rem_x);
+		scroll_stop();
+		return 0;
+	}
+
+	/* vertical step */
+	step = rem / scrollease;
+	if (step == 0 && rem != 0)
+		step = rem > 0 ? 1 : -1;
+	if (step > scrollcap)
+		step = scrollcap;
+	if (step < -scrollcap)
+		step = -scrollcap;
+
+	/* horizontal step */
+	step_x = rem_x / scrollease;
+	if (step_x == 0 && rem_x != 0)
+		step_x = rem_x > 0 ? 1 : -1;
+	if (step_x > scrollcap)
+		step_x = scrollcap;
+	if (step_x < -scrollcap)
+		step_x = -scrollcap;
+
+	TRACE(TRACE_SCROLL, trace_string("scroll"), now_nsec(), 0, rem, step);
+	if (rem_x)
+		TRACE(TRACE_SCROLL, trace_string("scroll_x"), now_nsec(), 0, rem_x, step_x);
+
+	pan(step_x, step);
+
+	mura.chord.scroll_pending_px -= step;
+	mura.chord.scroll_pending_px_x -= step_x;
+	wl_event_source_timer_update(mura.chord.scroll_timer, timerms);
+	return 0;
+}
+
+static int
+scroll_drag_tick(void *data)
+{
+	int32_t x, y;
+	int32_t delta_x, delta_y;
+
+	(void)data;
+
+	if (!mura.chord.scrolling) {
+		return 0;
+	}
+
+	if (!cursor_position(&x, &y)) {
+		wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
+		return 0;
+	}
+
+	delta_x = x - mura.chord.scroll_drag_last_x;
+	delta_y = y - mura.chord.scroll_drag_last_y;
+	mura.chord.scroll_drag_last_x = x;
+	mura.chord.scroll_drag_last_y = y;
+
+	if (delta_x == 0 && delta_y == 0) {
+		wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
+		return 0;
+	}
+
+	/* invert */
+	mura.chord.scroll_pending_px -= delta_y;
+	mura.chord.scroll_pending_px_x -= delta_x;
+	mura.chord.centre_start = 0;
+
+	/* update cursor direction based on drag direction */
+	if (delta_y != 0) {
+		mura.chord.scroll_cursor_dir = delta_y > 0 ? 1 : -1;
+		update_mode_cursor();
+	}
+
+	if (!mura.chord.scroll_timer)
+		mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+	if (mura.chord.scroll_timer)
+		wl_event_source_timer_update(mura.chord.scroll_timer, 1);
+
+	wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
+	return 0;
+}
+
+static void
+chord_axis(void *data, uint32_t time, uint32_t axis, int32_t value120)
+{
+	(void)data;
+
+	/* while moving a window swallow scroll events so they don't reach clients */
+	if (mura.chord.moving)
+		return;
+
+	/* in drag scroll mode, scroll wheel controls zoom when scrolling active */
+	if (scroll_drag_mode) {
+		if (enable_zoom && mura.chord.scrolling && axis == 0 && value120 != 0) {
+			/* vertical scroll wheel controls zoom with easing */
+			if (mura.chord.zoom_target == 0)
+				mura.chord.zoom_target = swc_get_zoom();
+			float delta = (value120 < 0) ? 0.15f : -0.15f;
+			mura.chord.zoom_target += delta;
+			if (mura.chord.zoom_target < 0.25f) mura.chord.zoom_target = 0.25f;
+			if (mura.chord.zoom_target > 4.0f) mura.chord.zoom_target = 4.0f;
+
+			/* Start or continue zoom animation */
+			if (!mura.chord.zoom_timer)
+				mura.chord.zoom_timer = add_timer(PERF_ZOOM_TICK);
+			if (mura.chord.zoom_timer)
+				wl_event_source_timer_update(mura.chord.zoom_timer, 1);
+			return;
+		}
+		swc_pointer_send_axis(time, axis, value120);
+		return;
+	}
+
+	if (!mura.chord.scrolling) {
+		swc_pointer_send_axis(time, axis, value120);
+		return;
+	}
+
+	/* only handle vertical scroll */
+	if (axis != 0 || value120 == 0) {
+		swc_pointer_send_axis(time, axis, value120);
+		return;
+	}
+
+	mura.chord.scroll_cursor_dir = value120 < 0 ? -1 : 1;
+	update_mode_cursor();
+
+	/* convert scroll wheel to viewport scroll */
+	int32_t dy = value120 * scrollpx / 120;
+	mura.chord.scroll_pending_px += dy;
+	mura.chord.centre_start = 0;
+
+	if (!mura.chord.scroll_timer)
+		mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+	if (mura.chord.scroll_timer)
+		wl_event_source_timer_update(mura.chord.scroll_timer, 1);
+}
+
+static void
+axis(void *data, uint32_t time, uint32_t axis, int32_t value120)
+{
+	uint64_t start;
+
+	/* real input is dropped while a replay drives the chords */
+	if (mura.input.replaying && !mura.input.feeding)
+		return;
+
+	input_record_motion();
+	input_record(INPUT_AXIS, (uint16_t)axis, value120, 0);
+
+	start = perf_start();
+	chord_axis(data, time, axis, value120);
+	perf_add(PERF_AXIS, start);
+}
+
+static void
+resize_outline(void)
+{
+	int32_t bw = (int32_t)(outer_border_width + inner_border_width);
+	struct swc_rectangle *start = &mura.chord.sizing.start;
+
+	swc_overlay_set_box(start->x - bw, start->y - bw,
+	                    start->x + (int32_t)mura.chord.sizing.width + bw,
+	                    start->y + (int32_t)mura.chord.sizing.height + bw,
+	                    select_box_color, select_box_border);
+}
+
+/* keep at most one configure in flight: the next size goes out a frame
+ * after the last one at the earliest, and only once the client acked it
+ * and committed (see tele_request()) or resize_ack_timeout_ms ran out.
+ * the commit counts whatever its size, clients snapped to cells or held
+ * at a minimum size answer with the size they had */
+static void
+resize_configure(bool force)
+{
+	uint64_t now = now_nsec();
+
+	if (!mura.chord.sizing.window)
+		return;
+
+	if (mura.chord.sizing.outstanding && !force) {
+		if (now - mura.chord.sizing.sent_at < (uint64_t)resize_ack_timeout_ms * 1000000)
+			return;
+		mura.chord.sizing.outstanding = false;
+	}
+	if (!force && now - mura.chord.sizing.sent_at < (uint64_t)timerms * 1000000)
+		return;
+	if (mura.chord.sizing.width == mura.chord.sizing.sent_width &&
+	    mura.chord.sizing.height == mura.chord.sizing.sent_height)
+		return;
+
+	swc_window_set_size(mura.chord.sizing.window, mura.chord.sizing.width, mura.chord.sizing.height);
+	wlist_moved(mura.chord.sizing.window);
+	mura.chord.sizing.sent_width = mura.chord.sizing.width;
+	mura.chord.sizing.sent_height = mura.chord.sizing.height;
+	mura.chord.sizing.sent_at = now;
+	mura.chord.sizing.outstanding = true;
+	mura.chord.sizing.acked = false;
+}
+
+static int
+resize_tick(void *data)
+{
+	(void)data;
+
+	if (!mura.chord.sizing.window)
+		return 0;
+
+	resize_configure(false);
+	wl_event_source_timer_update(mura.chord.sizing.timer, timerms);
+	return 0;
+}
+
+/* the client keeps showing its last buffer while the outline tracks the
+ * pointer, so a slow client never holds the box back */
+static void
+resize_follow(int32_t x, int32_t y)
+{
+	int32_t w = (int32_t)mura.chord.sizing.start.width + (x - mura.chord.sizing.cursor_x);
+	int32_t h = (int32_t)mura.chord.sizing.start.height + (y - mura.chord.sizing.cursor_y);
+
+	mura.chord.sizing.width = w < 50 ? 50 : (uint32_t)w;
+	mura.chord.sizing.height = h < 50 ? 50 : (uint32_t)h;
+	resize_outline();
+	resize_configure(false);
+}
+
+static void
+resize_begin(struct swc_window *swc)
+{
+	int32_t x, y;
+
+	if (!swc_window_get_geometry(swc, &mura.chord.sizing.start) || !cursor_position(&x, &y))
+		return;
+
+	mura.chord.sizing.window = swc;
+	mura.chord.sizing.cursor_x = x;
+	mura.chord.sizing.cursor_y = y;
+	mura.chord.sizing.width = mura.chord.sizing.sent_width = mura.chord.sizing.start.width;
+	mura.chord.sizing.height = mura.chord.sizing.sent_height = mura.chord.sizing.start.height;
+	mura.chord.sizing.sent_at = 0;
+	mura.chord.sizing.outstanding = false;
+	mura.chord.sizing.acked = false;
+	resize_outline();
+
+	if (!mura.chord.sizing.timer)
+		mura.chord.sizing.timer = add_timer(PERF_RESIZE_TICK);
+	if (mura.chord.sizing.timer)
+		wl_event_source_timer_update(mura.chord.sizing.timer, timerms);
+}
+
+static void
+resize_end(void)
+{
+	/* the final size always goes out, the client catches up on its own */
+	resize_configure(true);
+	mura.chord.sizing.window = NULL;
+	swc_overlay_clear();
+
+	if (mura.chord.sizing.timer) {
+		wl_event_source_remove(mura.chord.sizing.timer);
+		mura.chord.sizing.timer = NULL;
+	}
+}
+
+static void
+move_follow(int32_t x, int32_t y)
+{
+	struct swc_rectangle *geom;
+	int32_t sx, sy, depth = 0;
+
+	if (mura.focused) {
+		swc_window_set_position(mura.focused,
+		                        mura.chord.move_start_win_x + (x - mura.chord.move_start_cursor_x),
+		                        mura.chord.move_start_win_y + (y - mura.chord.move_start_cursor_y));
+		wlist_moved(mura.focused);
+	}
+
+	if (!mura.current_screen || !cursor_position_raw(&sx, &sy))
+		return;
+	geom = &mura.current_screen->swc->geometry;
+	sy -= geom->y;
+
+	/* the deeper into the edge band, the faster the plane pans */
+	if (sy < move_scroll_edge_threshold)
+		depth = move_scroll_edge_threshold - sy;
+	else if (sy > (int32_t)geom->height - move_scroll_edge_threshold)
+		depth = (int32_t)geom->height - move_scroll_edge_threshold - sy;
+
+	mura.chord.move_edge_velocity = depth * move_scroll_speed / move_scroll_edge_threshold;
+	if (mura.chord.move_edge_velocity == 0)
+		return;
+
+	if (!mura.chord.scroll_timer)
+		mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+	if (mura.chord.scroll_timer)
+		wl_event_source_timer_update(mura.chord.scroll_timer, 1);
+}
+
+/* runs once per event loop iteration, right after swc has dispatched the
+ * input that woke us, so whatever follows the pointer moves in the same
+ * dispatch as the motion itself */
+static void
+pointer_motion(void)
+{
+	int32_t x, y;
+	uint64_t start;
+
+	input_record_motion();
+
+	if (!cursor_position(&x, &y))
+		return;
+	if (x == mura.chord.motion_x && y == mura.chord.motion_y)
+		return;
+	mura.chord.motion_x = x;
+	mura.chord.motion_y = y;
+
+	start = perf_start();
+	if (mura.chord.moving && move_follow_pointer)
+		move_follow(x, y);
+	if (mura.chord.resize && mura.chord.sizing.window)
+		resize_follow(x, y);
+	perf_add(PERF_POINTER_MOTION, start);
+}
+
+static void
+windowdestroy(void *data)
+{
+	struct window *w = data;
+
+	/* cleanup for term spawn*/
+	if (w->spawn_parent) {
+		struct window *terminal = w->spawn_parent;
+
+		wl_list_remove(&w->spawn_link);
+
+		if (wl_list_empty(&terminal->spawn_children) && terminal->hidden_for_spawn) {
+			/* restore term */
+			swc_window_show(terminal->swc);
+			swc_window_set_geometry(terminal->swc, &terminal->saved_geometry);
+			terminal->hidden_for_spawn = false;
+			wlist_changed(terminal, WLIST_GEOMETRY | WLIST_VISIBLE);
+
+			/* focus terminal */
+			focus_window(terminal->swc, "spawn_child_destroyed");
+		}
+	}
+
+	if (!wl_list_empty(&w->spawn_children)) {
+		struct window *child, *tmp;
+		wl_list_for_each_safe(child, tmp, &w->spawn_children, spawn_link) {
+			child->spawn_parent = NULL;
+			wl_list_remove(&child->spawn_link);
+			wl_list_init(&child->spawn_link);
+		}
+	}
+
+	if (w->pooled)
+		pool_forget(w);
+	if (w->map_pending)
+		mura.map_pending--;
+	if (w->stat)
+		w->stat->window = NULL;
+	wl_list_remove(&w->pid_link);
+	if (mura.chord.sizing.window == w->swc) {
+		mura.chord.sizing.window = NULL;
+		swc_overlay_clear();
+	}
+	if(mura.focused == w->swc)
+		focus_window(NULL, "destroy");
+	wlist_forget(w);
+	wl_list_remove(&w->link);
+	free(w);
+}
+
+static void
+windowtitlechanged(void *data)
+{
+	wlist_changed(data, WLIST_TITLE);
+}
+
+static void
+windowappidchanged(void *data)
+{
+	struct window *w = data;
+	struct spawn_entry *e;
+	bool is_select = w->pid <= 0
+	              && !w->pooled
+	              && w->swc->app_id
+	              && strcmp(w->swc->app_id, select_term_app_id) == 0;
+
+	wlist_changed(w, WLIST_APP_ID);
+
+	/* windows with a pid were matched in newwindow(), this is only for
+	 * clients that hide theirs: give them the oldest selection */
+	if(!is_select)
+		return;
+
+	wl_list_for_each(e, &mura.spawns, link) {
+		if (e->kind == SPAWN_FOR_SELECT) {
+			place_spawned(w->swc, e->geometry);
+			perf_add(PERF_SPAWN_VISIBLE, e->start);
+			spawn_remove(e);
+			return;
+		}
+	}
+}
+
+static const struct swc_window_handler windowhandler = {
+	.destroy = windowdestroy,
+	.title_changed = windowtitlechanged,
+	.app_id_changed = windowappidchanged,
+};
+
+static void
+screendestroy(void *data)
+{
+	struct screen *s = data;
+	wl_list_remove(&s->link);
+	free(s);
+}
+
+static const struct swc_screen_handler screenhandler = {
+	.destroy = screendestroy,
+};
+
+static void
+newscreen(struct swc_screen *swc)
+{
+	struct screen *s;
+
+	s = malloc(sizeof(*s));
+	if(!s)
+		return;
+	s->swc = swc;
+	wl_list_insert(&mura.screens, &s->link);
+	swc_screen_set_handler(swc, &screenhandler, s);
+	TRACE(TRACE_SCREEN, 0, now_nsec(), 0, swc->geometry.width, swc->geometry.height);
+
+	if (!mura.chord.cursor_timer)
+		mura.chord.cursor_timer = add_timer(PERF_CURSOR_TICK);
+	if (mura.chord.cursor_timer)
+		wl_event_source_timer_update(mura.chord.cursor_timer, timerms);
+}
+
+/* helpers for pid*/
+static struct wl_list *
+pid_bucket(struct wl_list *table, pid_t pid)
+{
+	return &table[(uint32_t)pid * 2654435761u >> 24 & (PID_BUCKETS - 1)];
+}
+
+static struct proc *
+proc_find(pid_t pid)
+{
+	struct proc *p;
+
+	wl_list_for_each(p, pid_bucket(mura.procs, pid), link) {
+		if (p->pid == pid)
+			return p;
+	}
+	return NULL;
+}
+
+static void
+proc_remove(struct proc *p)
+{
+	if (p->source)
+		wl_event_source_remove(p->source);
+	if (p->pidfd >= 0)
+		close(p->pidfd);
+	wl_list_remove(&p->link);
+	free(p);
+}
+
+static int
+proc_exited(int fd, uint32_t mask, void *data)
+{
+	(void)fd;
+	(void)mask;
+	proc_remove(data);
+	return 0;
+}
+
+static int
+proc_pidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+	return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+	(void)pid;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/* remember pid's parent as reported by the spawn helper. with a pidfd the
+ * entry lives until the process exits, without one it is only trusted for
+ * proc_cache_ttl_ms */
+static void
+proc_add(pid_t pid, pid_t ppid)
+{
+	struct proc *p;
+	int fd;
+
+	if (pid <= 1 || ppid <= 0)
+		return;
+	if ((p = proc_find(pid)))
+		proc_remove(p);
+
+	fd = proc_pidfd(pid);
+	if (fd < 0 && errno != ENOSYS)
+		return; /* already gone */
+
+	p = calloc(1, sizeof(*p));
+	if (!p) {
+		if (fd >= 0)
+			close(fd);
+		return;
+	}
+	p->pid = pid;
+	p->ppid = ppid;
+	p->pidfd = fd;
+	p->stamp = now_nsec();
+	if (fd >= 0) {
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+		p->source = wl_event_loop_add_fd(mura.evloop, fd, WL_EVENT_READABLE, proc_exited, p);
+	}
+	wl_list_insert(pid_bucket(mura.procs, pid), &p->link);
+}
+
+/* 0 when the parent is not known yet */
+static pid_t
+proc_parent(pid_t pid)
+{
+	struct proc *p = proc_find(pid);
+
+	if (!p)
+		return 0;
+	if (p->pidfd < 0 && now_nsec() - p->stamp > (uint64_t)proc_cache_ttl_ms * 1000000) {
+		proc_remove(p);
+		return 0;
+	}
+	return p->ppid;
+}
+
+static void
+proc_clear(void)
+{
+	struct proc *p, *tmp;
+	int i;
+
+	for (i = 0; i < PID_BUCKETS; i++) {
+		wl_list_for_each_safe(p, tmp, &mura.procs[i], link)
+			proc_remove(p);
+	}
+}
+
+static bool
+is_terminal_window(struct window *w)
+{
+	if (!w || !w->swc)
+		return false;
+
+	/* check app_id */
+	if (w->swc->app_id) {
+		for (const char *const *term = terminal_app_ids; *term; term++) {
+			if (strstr(w->swc->app_id, *term))
+				return true;
+		}
+	}
+
+	/* check title too, because, paranoia */
+	if (w->swc->title) {
+		for (const char *const *term = terminal_app_ids; *term; term++) {
+			if (strstr(w->swc->title, *term))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static struct window *
+find_terminal_by_pid(pid_t pid)
+{
+	struct window *w;
+
+	wl_list_for_each(w, pid_bucket(mura.window_pids, pid), pid_link) {
+		if (w->pid == pid && is_terminal_window(w))
+			return w;
+	}
+	return NULL;
+}
+
+enum swallow_result {
+	SWALLOW_NONE,
+	SWALLOW_FOUND,
+	SWALLOW_UNKNOWN, /* part of the process tree is not cached yet */
+};
+
+/* we need to walk up the proc tree to get the term, otherwise we just get
+ * the shell. only looks at the cache, never at /proc */
+static enum swallow_result
+swallow_resolve(struct window *w, struct window **terminal)
+{
+	pid_t current_pid = w->pid, parent_pid;
+	int depth;
+
+	for (depth = 0; depth < SPAWN_PARENTS_MAX && current_pid > 1; depth++) {
+		parent_pid = proc_parent(current_pid);
+		if (parent_pid == 0)
+			return SWALLOW_UNKNOWN;
+		if (parent_pid <= 1)
+			break;
+
+		/* check pid against term*/
+		if ((*terminal = find_terminal_by_pid(parent_pid)))
+			return SWALLOW_FOUND;
+
+		current_pid = parent_pid;
+	}
+	return SWALLOW_NONE;
+}
+
+static void
+mk_spawn_link(struct window *terminal, struct window *child)
+{
+	child->spawn_parent = terminal;
+	wl_list_insert(&terminal->spawn_children, &child->spawn_link);
+
+	/* save term geom */
+	if (swc_window_get_geometry(terminal->swc, &terminal->saved_geometry)) {
+		terminal->hidden_for_spawn = true;
+		swc_window_hide(terminal->swc);
+		swc_window_set_geometry(child->swc, &terminal->saved_geometry);
+		wlist_changed(terminal, WLIST_VISIBLE);
+		wlist_changed(child, WLIST_GEOMETRY);
+	}
+}
+
+/* the helper has reported the ancestors of pid. windows waiting on them
+ * were shown right away and get their swallow now */
+static void
+swallow_answered(pid_t pid)
+{
+	struct window *w, *terminal;
+
+	wl_list_for_each(w, pid_bucket(mura.window_pids, pid), pid_link) {
+		if (w->pid != pid || !w->swallow_pending)
+			continue;
+		w->swallow_pending = false;
+		if (swallow_resolve(w, &terminal) == SWALLOW_FOUND)
+			mk_spawn_link(terminal, w);
+	}
+}
+
+/* the helper found which spawn started pid. its window is already shown,
+ * so a selection moves it into place and a pool terminal is hidden again */
+static void
+spawn_token_answered(pid_t pid, uint32_t token)
+{
+	struct window *w;
+	struct spawn_entry *e = token ? spawn_find(token) : NULL;
+
+	wl_list_for_each(w, pid_bucket(mura.window_pids, pid), pid_link) {
+		if (w->pid != pid || !w->token_pending)
+			continue;
+		w->token_pending = false;
+		if (!e || e->window)
+			continue;
+
+		if (e->kind == SPAWN_FOR_POOL) {
+			e->window = w;
+			w->pooled = true;
+			swc_window_hide(w->swc);
+			wlist_changed(w, WLIST_VISIBLE);
+			if (mura.focused == w->swc)
+				focus_window(NULL, "pooled");
+		} else {
+			place_spawned(w->swc, e->geometry);
+			perf_add(PERF_SPAWN_VISIBLE, e->start);
+			spawn_remove(e);
+		}
+		e = NULL;
+	}
+}
+
+static void
+manage_window(struct swc_window *swc)
+{
+	struct window *w;
+	struct spawn_entry *e;
+
+	w = malloc(sizeof(*w));
+	if(!w)
+		return;
+	w->swc = swc;
+	w->pid = 0;
+	wl_list_init(&w->pid_link);
+	w->swallow_pending = false;
+	w->token_pending = false;
+	w->spawn_parent = NULL;
+	wl_list_init(&w->spawn_children);
+	wl_list_init(&w->spawn_link);
+	w->hidden_for_spawn = false;
+	w->sticky = false;
+	w->pooled = false;
+	w->map_pending = false;
+	w->id = ++mura.tele.next_window_id;
+	/* swc makes the window inside the surface's commit or get_toplevel */
+	w->stat = mura.tele.current;
+	if (w->stat && !w->stat->window)
+		w->stat->window = w;
+	else
+		w->stat = NULL;
+	w->map_width = w->map_height = 0;
+	w->map_start = now_nsec();
+	w->spawn_start = 0;
+	w->dirty = 0;
+	w->listed = false;
+
+	wl_list_insert(&mura.windows, &w->link);
+	swc_window_set_handler(swc, &windowhandler, w);
+	swc_window_set_stacked(swc);
+	swc_window_set_border(swc, inner_border_color_inactive, inner_border_width, outer_border_color_inactive, outer_border_width);
+
+	/* pool terminals stay hidden until a selection takes them */
+	w->pid = swc_window_get_pid(swc);
+	if (w->pid > 0)
+		wl_list_insert(pid_bucket(mura.window_pids, w->pid), &w->pid_link);
+	e = spawn_claim(w);
+	if (e && e->kind == SPAWN_FOR_POOL) {
+		e->window = w;
+		w->pooled = true;
+		return;
+	}
+
+	/* get pid and check conf for term spawn. a tree the cache does not
+	 * know yet is asked of the spawn helper, the window is shown meanwhile */
+	if (enable_terminal_spawning && w->pid > 0) {
+		struct window *terminal;
+
+		switch (swallow_resolve(w, &terminal)) {
+		case SWALLOW_FOUND:
+			mk_spawn_link(terminal, w);
+			break;
+		case SWALLOW_UNKNOWN:
+			if (mura.spawner.fd >= 0 && spawn_request_parents(mura.spawner.fd, w->pid)) {
+				spawner_watch();
+				w->swallow_pending = true;
+			}
+			break;
+		case SWALLOW_NONE:
+			break;
+		}
+	}
+
+	if (e) {
+		struct swc_rectangle geometry = e->geometry;
+
+		place_spawned(swc, geometry);
+		w->spawn_start = e->start;
+		spawn_remove(e);
+
+		/* started at this size, wait for the frame that has it */
+		if (term_sized_spawn()) {
+			map_defer(w, geometry.width, geometry.height);
+			return;
+		}
+	}
+
+	if (w->spawn_start)
+		perf_add(PERF_SPAWN_VISIBLE, w->spawn_start);
+	swc_window_show(swc);
+	wlist_changed(w, WLIST_ALL);
+	TRACE(TRACE_WINDOW, 0, now_nsec(), 0, trace_window(swc), w->pid);
+	focus_window(swc, "new_window");
+}
+
+/* swc calls this from inside a client request, which keeps running after
+ * it, so it is timed without closing the request */
+static void
+newwindow(struct swc_window *swc)
+{
+	uint64_t start = now_nsec();
+
+	manage_window(swc);
+	perf_add(PERF_NEWWINDOW, start);
+}
+
+/* gestures move the plane by exactly what the fingers moved, in the same
+ * dispatch, sub-pixel remainders carry over to the next update */
+static void
+gesture_pan(struct libinput_event_gesture *ev)
+{
+	double dx = libinput_event_gesture_get_dx(ev);
+	double dy = libinput_event_gesture_get_dy(ev);
+	uint64_t usec = libinput_event_gesture_get_time_usec(ev);
+	double ms = (usec - mura.gesture.last_usec) / 1000.0;
+	int32_t px, py;
+
+	if (!gesture_natural) {
+		dx = -dx;
+		dy = -dy;
+	}
+	if (!scroll_drag_mode)
+		dx = 0;
+
+	/* smoothed finger speed for the fling */
+	if (mura.gesture.last_usec && ms > 0) {
+		mura.gesture.vel_x = (mura.gesture.vel_x + dx / ms) / 2;
+		mura.gesture.vel_y = (mura.gesture.vel_y + dy / ms) / 2;
+	}
+	mura.gesture.last_usec = usec;
+
+	mura.gesture.rem_x += dx;
+	mura.gesture.rem_y += dy;
+	px = (int32_t)mura.gesture.rem_x;
+	py = (int32_t)mura.gesture.rem_y;
+	mura.gesture.rem_x -= px;
+	mura.gesture.rem_y -= py;
+
+	if (px != 0 || py != 0)
+		pan(px, py);
+}
+
+static void
+gesture_begin(void)
+{
+	scroll_stop();
+	mura.gesture.rem_x = mura.gesture.rem_y = 0;
+	mura.gesture.vel_x = mura.gesture.vel_y = 0;
+	mura.gesture.last_usec = 0;
+}
+
+/* hand the finger speed to the pan tick, whose easing starts out at
+ * pending / (scrollease * timerms) px per ms */
+static void
+gesture_fling_start(struct libinput_event_gesture *ev)
+{
+	uint64_t usec = libinput_event_gesture_get_time_usec(ev);
+
+	if (!gesture_fling || libinput_event_gesture_get_cancelled(ev))
+		return;
+	/* fingers rested before lifting */
+	if (usec - mura.gesture.last_usec > 50000)
+		return;
+
+	mura.chord.scroll_pending_px = (int32_t)(mura.gesture.vel_y * scrollease * timerms);
+	mura.chord.scroll_pending_px_x = (int32_t)(mura.gesture.vel_x * scrollease * timerms);
+	if (mura.chord.scroll_pending_px == 0 && mura.chord.scroll_pending_px_x == 0)
+		return;
+
+	mura.chord.auto_scrolling = true;
+	mura.chord.centre_start = 0;
+	if (!mura.chord.scroll_timer)
+		mura.chord.scroll_timer = add_timer(PERF_SCROLL_TICK);
+	if (mura.chord.scroll_timer)
+		wl_event_source_timer_update(mura.chord.scroll_timer, 1);
+}
+
+static void
+gesture_pinch(struct libinput_event_gesture *ev)
+{
+	float zoom = mura.gesture.zoom_start * (float)libinput_event_gesture_get_scale(ev);
+
+	if (zoom < 0.25f) zoom = 0.25f;
+	if (zoom > 4.0f) zoom = 4.0f;
+
+	/* keep zoom_tick from easing back to an older target */
+	mura.chord.zoom_target = zoom;
+	swc_set_zoom(zoom);
+	camera_changed();
+}
+
+static int
+gesture_dispatch(int fd, uint32_t mask, void *data)
+{
+	struct libinput_event *ev;
+	uint64_t start = perf_start();
+
+	(void)fd;
+	(void)mask;
+	(void)data;
+
+	libinput_dispatch(mura.gesture.li);
+	while ((ev = libinput_get_event(mura.gesture.li))) {
+		switch (libinput_event_get_type(ev)) {
+		case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+			gesture_begin();
+			break;
+		case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+			gesture_pan(libinput_event_get_gesture_event(ev));
+			break;
+		case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+			gesture_fling_start(libinput_event_get_gesture_event(ev));
+			break;
+		case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+			gesture_begin();
+			mura.gesture.zoom_start = swc_get_zoom();
+			break;
+		case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+			if (enable_zoom)
+				gesture_pinch(libinput_event_get_gesture_event(ev));
+			gesture_pan(libinput_event_get_gesture_event(ev));
+			break;
+		default:
+			break;
+		}
+		libinput_event_destroy(ev);
+	}
+
+	perf_add(PERF_GESTURE, start);
+	return 0;
+}
+
+static int
+gesture_open(const char *path, int flags, void *data)
+{
+	int fd;
+
+	(void)data;
+	fd = open(path, flags | O_CLOEXEC);
+	return fd < 0 ? -errno : fd;
+}
+
+static void
+gesture_close(int fd, void *data)
+{
+	(void)data;
+	close(fd);
+}
+
+static const struct libinput_interface gesture_interface = {
+	.open_restricted = gesture_open,
+	.close_restricted = gesture_close,
+};
+
+static void
+gesture_device_remove(struct gesture_device *gd)
+{
+	libinput_path_remove_device(gd->dev);
+	wl_list_remove(&gd->link);
+	free(gd->syspath);
+	free(gd);
+}
+
+/* a path context never hears that a device went away, so udev tells us
+ * and the device leaves the context. devices are told apart by syspath:
+ * a touchpad plugged back in may get the same node but not the same path */
+static int
+gesture_monitor(int fd, uint32_t mask, void *data)
+{
+	struct udev_device *udev;
+	struct gesture_device *gd, *tmp;
+	const char *action, *syspath;
+
+	(void)fd;
+	(void)mask;
+	(void)data;
+
+	while ((udev = udev_monitor_receive_device(mura.gesture.monitor))) {
+		action = udev_device_get_action(udev);
+		syspath = udev_device_get_syspath(udev);
+		if (action && syspath && strcmp(action, "remove") == 0) {
+			wl_list_for_each_safe(gd, tmp, &mura.gesture.devices, link) {
+				if (strcmp(gd->syspath, syspath) == 0)
+					gesture_device_remove(gd);
+			}
+		}
+		udev_device_unref(udev);
+	}
+	return 0;
+}
+
+static void
+gesture_monitor_start(struct udev *udev)
+{
+	struct udev_monitor *monitor;
+
+	monitor = udev_monitor_new_from_netlink(udev, "udev");
+	if (!monitor)
+		return;
+	if (udev_monitor_filter_add_match_subsystem_devtype(monitor, "input", NULL) < 0 ||
+	    udev_monitor_enable_receiving(monitor) < 0) {
+		udev_monitor_unref(monitor);
+		return;
+	}
+	mura.gesture.monitor = monitor;
+	mura.gesture.monitor_source = wl_event_loop_add_fd(mura.evloop, udev_monitor_get_fd(monitor),
+	                                                   WL_EVENT_READABLE, gesture_monitor, NULL);
+}
+
+/* swc keeps the gesture events of its own libinput context to itself, so
+ * touchpads are opened a second time in a context that only mura reads */
+static void
+newdevice(struct libinput_device *dev)
+{
+	struct udev_device *udev;
+	struct gesture_device *gd;
+	struct libinput_device *added;
+	const char *node, *syspath;
+
+	if (!enable_gestures || !libinput_device_has_capability(dev, LIBINPUT_DEVICE_CAP_GESTURE))
+		return;
+
+	if (!mura.gesture.li) {
+		mura.gesture.li = libinput_path_create_context(&gesture_interface, NULL);
+		if (!mura.gesture.li)
+			return;
+		mura.gesture.source = wl_event_loop_add_fd(mura.evloop, libinput_get_fd(mura.gesture.li),
+		                                           WL_EVENT_READABLE, gesture_dispatch, NULL);
+	}
+
+	udev = libinput_device_get_udev_device(dev);
+	if (!udev)
+		return;
+	if (!mura.gesture.monitor)
+		gesture_monitor_start(udev_device_get_udev(udev));
+	node = udev_device_get_devnode(udev);
+	syspath = udev_device_get_syspath(udev);
+
+	wl_list_for_each(gd, &mura.gesture.devices, link) {
+		if (syspath && strcmp(gd->syspath, syspath) == 0)
+			node = NULL;
+	}
+
+	if (node && syspath && (added = libinput_path_add_device(mura.gesture.li, node))) {
+		gd = malloc(sizeof(*gd));
+		if (gd && (gd->syspath = strdup(syspath))) {
+			gd->dev = added;
+			wl_list_insert(&mura.gesture.devices, &gd->link);
+		} else {
+			free(gd);
+			libinput_path_remove_device(added);
+		}
+	} else if (node) {
+		fprintf(stderr, "cannot read gestures from %s\n", node);
+	}
+
+	udev_device_unref(udev);
+}
+
+/* swc gives up its devices when the session is switched away, mura's own
+ * touchpads go with them so the other session's swipes stay there */
+static void
+activate(void)
+{
+	if (mura.gesture.li && libinput_resume(mura.gesture.li) < 0)
+		fprintf(stderr, "cannot resume gestures\n");
+}
+
+static void
+deactivate(void)
+{
+	if (!mura.gesture.li)
+		return;
+	libinput_suspend(mura.gesture.li);
+	scroll_stop();
+}
+
 static const struct swc_manager manager = {
 	.new_screen = newscreen,
 	.new_window = newwindow,
 	.new_device = newdevice,
+	.activate = activate,
+	.deactivate = deactivate,
 };
 
+static void
+chord_button(void *data, uint32_t time, uint32_t b, uint32_t state)
+{
+	const char *name;
+	bool pressed;
+	int32_t x, y;
+	struct swc_rectangle geometry;
+	bool was_left = mura.chord.left;
+	bool was_right = mura.chord.right;
+	//bool was_middle = mura.chord.middle;
+	bool is_lr;
+	bool is_chord_button;
+	bool acme_passthrough = false;
+
+	(void)data;
+	(void)time;
+
+	pressed = (state == WL_POINTER_BUTTON_STATE_PRESSED);
+
+	switch(b){
+	case BTN_LEFT:
+		name = "left";
+		mura.chord.left = pressed;
+		break;
+	case BTN_MIDDLE:
+		name = "middle";
+		mura.chord.middle = pressed;
+		break;
+	case BTN_RIGHT:
+		name = "right";
+		mura.chord.right = pressed;
+		break;
+	default:
+		name = "unknown";
+		break;
+	}
+
+	TRACE(TRACE_BUTTON, trace_string(name), now_nsec(), 0, (int32_t)b, pressed);
+
+	is_lr = (b == BTN_LEFT || b == BTN_RIGHT);
+	is_chord_button = (is_lr || b == BTN_MIDDLE);
+
+	if (cursor_position(&x, &y)) {
+		struct swc_window *target = swc_window_at(x, y);
+		if (is_acme(target) && target == mura.focused)
+			acme_passthrough = true;
+	}
+
+	/* allow 1-3 chord to go to acme specifically */
+	if (acme_passthrough && is_lr && pressed) {
+		bool other_down = (b == BTN_LEFT) ? was_right : was_left;
+
+		if (other_down) {
+			swc_pointer_send_button(time, b, state);
+			return;
+		}
+	}
+
+	if (b == BTN_LEFT && !pressed && mura.chord.killing) {
+		if (cursor_position(&x, &y)) {
+			struct swc_window *target = swc_window_at(x, y);
+
+			if (target)
+				swc_window_close(target);
+		}
+		mura.chord.killing = false;
+		update_mode_cursor();
+		if (!mura.chord.left && !mura.chord.middle && !mura.chord.right)
+			mura.chord.activated = false;
+		return;
+	}
+
+	if (b == BTN_LEFT && pressed && was_right && !mura.chord.activated && !acme_passthrough) {
+		click_cancel();
+		stop_select();
+		mura.chord.activated = true;
+		mura.chord.killing = true;
+		update_mode_cursor();
+		return;
+	}
+
+	if (b == BTN_MIDDLE && pressed && was_right && !mura.chord.activated) {
+		click_cancel();
+		stop_select();
+		mura.chord.activated = true;
+		mura.chord.scrolling = true;
+		mura.chord.scroll_cursor_dir = -1;
+		update_mode_cursor();
+		scroll_stop();
+
+		/* start drag-to-scroll tracking (if enabled) */
+		if (scroll_drag_mode) {
+			if (cursor_position(&x, &y)) {
+				mura.chord.scroll_drag_last_x = x;
+				mura.chord.scroll_drag_last_y = y;
+			}
+			if (!mura.chord.scroll_drag_timer)
+				mura.chord.scroll_drag_timer = add_timer(PERF_SCROLL_DRAG_TICK);
+			if (mura.chord.scroll_drag_timer)
+				wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
+		}
+
+		TRACE(TRACE_MARK, trace_string("scroll: start"), now_nsec(), 0, 0, 0);
+		return;
+	}
+
+	if (b == BTN_MIDDLE && !pressed && was_left && ! mura.chord.activated &&
+	    !mura.chord.selecting && !acme_passthrough) {
+		click_cancel();
+		stop_select();
+		mura.chord.activated = true;
+		mura.chord.moving = true;
+		update_mode_cursor();
+
+		/* get starting pos to be used for easing calculation*/
+		if(mura.focused && cursor_position(&x, &y)){
+			struct swc_rectangle geometry;
+			if(swc_window_get_geometry(mura.focused, &geometry)){
+				mura.chord.move_start_win_x = geometry.x;
+				mura.chord.move_start_win_y = geometry.y;
+				mura.chord.move_start_cursor_x = x;
+				mura.chord.move_start_cursor_y = y;
+			}
+		}
+
+		/* auto-scroll timer for scroll durin win move, direct moves
+		 * are driven from pointer_motion() instead */
+		mura.chord.move_edge_velocity = 0;
+		if (!move_follow_pointer) {
+			if(!mura.chord.move_scroll_timer)
+				mura.chord.move_scroll_timer = add_timer(PERF_MOVE_SCROLL_TICK);
+			if(mura.chord.move_scroll_timer)
+				wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
+		}
+
+		/* forward the release so clients dont see stuck */
+		swc_pointer_send_button(time, b, state);
+
+		return;
+	}
+
+	if (b == BTN_LEFT && !pressed && mura.chord.moving == true) {
+		mura.chord.moving = false;
+		mura.chord.move_edge_velocity = 0;
+		update_mode_cursor();
+
+		/* stop timer */
+		if(mura.chord.move_scroll_timer){
+			wl_event_source_remove(mura.chord.move_scroll_timer);
+			mura.chord.move_scroll_timer = NULL;
+		}
+
+		if (!mura.chord.left && !mura.chord.middle && !mura.chord.right)
+			mura.chord.activated = false;
+
+		/* forward the release so clients dont see stuk */
+		swc_pointer_send_button(time, b, state);
+
+		return;
+	}
+
+	if (b == BTN_MIDDLE && !pressed && was_right && ! mura.chord.activated && !mura.chord.selecting) {
+		click_cancel();
+		stop_select();
+		mura.chord.activated = true;
+		mura.chord.resize = true;
+		update_mode_cursor();
+
+		if (mura.focused && resize_coalesce)
+			resize_begin(mura.focused);
+		else if (mura.focused)
+			/* bottom right */
+			swc_window_begin_resize(mura.focused, SWC_WINDOW_EDGE_RIGHT | SWC_WINDOW_EDGE_BOTTOM);
+
+
+		/* forward the middle release so clients don't see it stuck */
+		swc_pointer_send_button(time, b, state);
+
+		return;
+	}
+
+	if (b == BTN_RIGHT && !pressed && mura.chord.resize == true) {
+		mura.chord.resize = false;
+		update_mode_cursor();
+
+		if (resize_coalesce) {
+			if (mura.chord.sizing.window)
+				resize_end();
+		} else if (mura.focused)
+			swc_window_end_resize(mura.focused);
+
+		if (!mura.chord.left && !mura.chord.middle && !mura.chord.right)
+			mura.chord.activated = false;
+
+		/* let clients see the release we swallowed */
+		swc_pointer_send_button(time, b, state);
+
+		return;
+	}
+
+	if (b == BTN_MIDDLE && pressed && was_left && !mura.chord.activated) {
+		click_cancel();
+		stop_select();
+
+		if (mura.focused) {
+			struct window *w;
+			wl_list_for_each(w, &mura.windows, link) {
+				if (w->swc == mura.focused) {
+					#if defined(STICKY)
+						w->sticky = !w->sticky;
+					#elif defined(FULLSCREEN)
+						w->sticky = !w->sticky;
+						swc_window_set_fullscreen(mura.focused, mura.current_screen->swc);
+						wlist_moved(mura.focused);
+					#elif defined(JUMP)
+						bool state = focus_center;
+						focus_center = true;
+						mura.chord.jumping = true;
+						struct window *closest = NULL;
+						struct window *n;
+						struct swc_rectangle ngeom;
+
+						int32_t x = 0, y = 0;
+						cursor_position_raw(&x, &y);
+						int64_t mindist = INT64_MAX;
+						wl_list_for_each(n, &mura.windows, link) {
+							if (!n->swc || n->pooled)
+								continue;
+
+							if (!swc_window_get_geometry(n->swc, &ngeom))
+								continue;
+
+							/* makes a cool switcher thingy */
+							if (n->swc == mura.focused)
+								continue;
+
+							int64_t dx = (int64_t)x - (int64_t)ngeom.x;
+							int64_t dy = (int64_t)y - (int64_t)ngeom.y;
+
+							/* fuck sqrt() */
+							int64_t dist = dx*dx + dy*dy;
+
+							if (dist < mindist) {
+								closest = n;
+								mindist = dist;
+							}
+						}
+
+						if (closest != NULL)
+							focus_window(closest->swc, "jump");
+
+						mura.chord.jumping = false;
+						focus_center = state;
+					#endif
+					break;
+				}
+			}
+		}
+
+		mura.chord.activated = true;
+		swc_pointer_send_button(time, b, state);
+		return;
+	}
+
+	if (b == BTN_MIDDLE && !pressed && mura.chord.scrolling) {
+		return;
+	}
+
+	if (pressed && is_lr && !mura.chord.selecting) {
+		bool other_down = (b == BTN_LEFT) ? was_right : was_left;
+
+		/* stop auto-scrolling on any clics */
+		if (mura.chord.auto_scrolling) {
+			mura.chord.auto_scrolling = false;
+			scroll_stop();
+		}
+
+		/* only left button focuses windows */
+		if (b == BTN_LEFT && !other_down && cursor_position(&x, &y)) {
+			struct swc_window *target = swc_window_at(x, y);
+
+			if (target)
+				focus_window(target, "click");
+		}
+	}
+
+	if(mura.chord.left && mura.chord.right && !mura.chord.activated && !acme_passthrough){
+		click_cancel();
+		mura.chord.activated = true;
+		if(cursor_position(&x, &y)){
+			mura.chord.selecting = true;
+			update_mode_cursor();
+			mura.chord.start_x = x;
+			mura.chord.start_y = y;
+			mura.chord.cur_x = x;
+			mura.chord.cur_y = y;
+			swc_overlay_set_box(x, y, x, y, select_box_color, select_box_border);
+			if(!mura.chord.timer)
+				mura.chord.timer = add_timer(PERF_SELECT_TICK);
+			if(mura.chord.timer)
+				wl_event_source_timer_update(mura.chord.timer, timerms);
+		}
+	}
+
+	/* while a chord is active swallow left/right events so they don't go to clients */
+	if(is_chord_button && mura.chord.activated && !mura.chord.selecting){
+		bool was_scrolling = mura.chord.scrolling;
+		if (!mura.chord.right)
+			mura.chord.scrolling = false;
+		if (was_scrolling && !mura.chord.scrolling)
+			update_mode_cursor();
+		if (!mura.chord.scrolling) {
+			TRACE(TRACE_MARK, trace_string("scroll: release"), now_nsec(), 0, 0, 0);
+			scroll_stop();
+		}
+		if(!mura.chord.left && !mura.chord.middle && !mura.chord.right)
+			mura.chord.activated = false;
+		return;
+	}
+
+	if (b == BTN_MIDDLE) {
+		if (mura.chord.moving)
+			return;
+		swc_pointer_send_button(time, b, state);
+		return;
+	}
+
+	/* pass normal clicks through to clients */
+	if(is_lr && pressed && !mura.chord.selecting){
+		bool other_down = (b == BTN_LEFT) ? was_right : was_left;
+		if(other_down){
+			/* chord will activate via the block above */
+		} else if(!mura.chord.click.pending) {
+			mura.chord.click.pending = true;
+			mura.chord.click.forwarded = false;
+			mura.chord.click.button = b;
+			mura.chord.click.time = time;
+			if(!mura.chord.click_timer)
+				mura.chord.click_timer = add_timer(PERF_CLICK_TIMEOUT);
+			if(mura.chord.click_timer)
+				wl_event_source_timer_update(mura.chord.click_timer, chord_click_timeout_ms);
+			return;
+		}
+	}
+
+	if(is_lr && !pressed && !mura.chord.selecting){
+		if(mura.chord.click.pending && mura.chord.click.button == b){
+			if(!mura.chord.click.forwarded){
+				swc_pointer_send_button(mura.chord.click.time, mura.chord.click.button,
+				                        WL_POINTER_BUTTON_STATE_PRESSED);
+			}
+			swc_pointer_send_button(time, b, WL_POINTER_BUTTON_STATE_RELEASED);
+			click_cancel();
+			return;
+		}
+		swc_pointer_send_button(time, b, WL_POINTER_BUTTON_STATE_RELEASED);
+		return;
+	}
+
+	if(b == BTN_RIGHT && !pressed && mura.chord.selecting){
+		int32_t x1, y1, x2, y2;
+		uint32_t outer_w, outer_h;
+		uint32_t bw = outer_border_width + inner_border_width;
+
+		if(!cursor_position(&x, &y)){
+			x = mura.chord.cur_x;
+			y = mura.chord.cur_y;
+		}
+		stop_select();
+
+		x1 = mura.chord.start_x < x ? mura.chord.start_x : x;
+		y1 = mura.chord.start_y < y ? mura.chord.start_y : y;
+		x2 = mura.chord.start_x < x ? x : mura.chord.start_x;
+		y2 = mura.chord.start_y < y ? y : mura.chord.start_y;
+		outer_w = (uint32_t)abs(x2 - x1);
+		outer_h = (uint32_t)abs(y2 - y1);
+		if(outer_w < (50 + 2 * bw))
+			outer_w = 50 + 2 * bw;
+		if(outer_h < (50 + 2 * bw))
+			outer_h = 50 + 2 * bw;
+
+		/* swc_window_set_*  content geom */
+		geometry.x = x1 + (int32_t)bw;
+		geometry.y = y1 + (int32_t)bw;
+		geometry.width = outer_w > 2 * bw ? outer_w - 2 * bw : 1;
+		geometry.height = outer_h > 2 * bw ? outer_h - 2 * bw : 1;
+		spawn_term_select(&geometry);
+		TRACE(TRACE_SPAWN, 0, now_nsec(), 0, (int32_t)geometry.width, (int32_t)geometry.height);
+	}
+
+	if(!is_lr){
+		swc_pointer_send_button(time, b, state);
+		return;
+	}
+
+	if(!mura.chord.left && !mura.chord.middle && !mura.chord.right)
+		mura.chord.activated = false;
+}
+
 static void
 button(void *data, uint32_t time, uint32_t b, uint32_t state)
 {
-	const char *name;
-	bool pressed;
-	int32_t x, y;
-	struct swc_rectangle geometry;
-	bool was_left = mura.chord.left;
-	bool was_right = mura.chord.right;
-	//bool was_middle = mura.chord.middle;
-	bool is_lr;
-	bool is_chord_button;
-	bool acme_passthrough = false;
+	uint64_t start;
 
-	(void)data;
-	(void)time;
+	if (mura.input.replaying && !mura.input.feeding)
+		return;
 
-	pressed = (state == WL_POINTER_BUTTON_STATE_PRESSED);
+	input_record_motion();
+	input_record(INPUT_BUTTON, (uint16_t)b, (int32_t)state, 0);
 
-	switch(b){
-	case BTN_LEFT:
-		name = "left";
-		mura.chord.left = pressed;
-		break;
-	case BTN_MIDDLE:
-		name = "middle";
-		mura.chord.middle = pressed;
-		break;
-	case BTN_RIGHT:
-		name = "right";
-		mura.chord.right = pressed;
-		break;
-	default:
-		name = "unknown";
-		break;
-	}
+	start = perf_start();
+	chord_button(data, time, b, state);
+	perf_add(PERF_BUTTON, start);
+}
 
-	printf("button %s (%d) %s\n", name, b, pressed ? "pressed" : "released");
+static void
+terminate(void)
+{
+	running = 0;
+	wl_display_terminate(mura.display);
+}
 
-	is_lr = (b == BTN_LEFT || b == BTN_RIGHT);
-	is_chord_button = (is_lr || b == BTN_MIDDLE);
+static bool
+record_open(const char *path)
+{
+	struct input_trace_header hdr = { INPUT_TRACE_MAGIC, INPUT_TRACE_VERSION };
 
-	if (cursor_position(&x, &y)) {
-		struct swc_window *target = swc_window_at(x, y);
-		if (is_acme(target) && target == mura.focused)
-			acme_passthrough = true;
+	mura.input.record = fopen(path, "wb");
+	if (!mura.input.record) {
+		fprintf(stderr, "cannot open %s for recording\n", path);
+		return false;
 	}
+	fwrite(&hdr, sizeof(hdr), 1, mura.input.record);
+	mura.input.record_start = now_nsec();
+	mura.input.record_x = INT32_MIN;
+	mura.input.record_y = INT32_MIN;
+	return true;
+}
 
-	/* allow 1-3 chord to go to acme specifically */
-	if (acme_passthrough && is_lr && pressed) {
-		bool other_down = (b == BTN_LEFT) ? was_right : was_left;
+static bool
+replay_load(const char *path)
+{
+	struct input_trace_header hdr;
+	struct input_event ev, *events;
+	size_t cap = 0;
+	FILE *f;
 
-		if (other_down) {
-			swc_pointer_send_button(time, b, state);
-			return;
-		}
+	f = fopen(path, "rb");
+	if (!f) {
+		fprintf(stderr, "cannot open %s\n", path);
+		return false;
 	}
 
-	if (b == BTN_LEFT && !pressed && mura.chord.killing) {
-		if (cursor_position(&x, &y)) {
-			struct swc_window *target = swc_window_at(x, y);
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+	    hdr.magic != INPUT_TRACE_MAGIC || hdr.version != INPUT_TRACE_VERSION) {
+		fprintf(stderr, "%s: not a mura input trace\n", path);
+		fclose(f);
+		return false;
+	}
 
-			if (target)
-				swc_window_close(target);
+	while (fread(&ev, sizeof(ev), 1, f) == 1) {
+		if (mura.input.nevents == cap) {
+			cap = cap ? cap * 2 : 1024;
+			events = realloc(mura.input.events, cap * sizeof(*events));
+			if (!events) {
+				fclose(f);
+				return false;
+			}
+			mura.input.events = events;
 		}
-		mura.chord.killing = false;
-		update_mode_cursor();
-		if (!mura.chord.left && !mura.chord.middle && !mura.chord.right)
-			mura.chord.activated = false;
-		return;
+		mura.input.events[mura.input.nevents++] = ev;
 	}
 
-	if (b == BTN_LEFT && pressed && was_right && !mura.chord.activated && !acme_passthrough) {
-		click_cancel();
-		stop_select();
-		mura.chord.activated = true;
-		mura.chord.killing = true;
-		update_mode_cursor();
-		return;
+	fclose(f);
+	return true;
+}
+
+static void
+replay_event(const struct input_event *ev)
+{
+	switch (ev->type) {
+	case INPUT_MOTION:
+		mura.input.x = ev->a;
+		mura.input.y = ev->b;
+		break;
+	case INPUT_BUTTON:
+		button(NULL, ev->msec, ev->code, (uint32_t)ev->a);
+		break;
+	case INPUT_AXIS:
+		axis(NULL, ev->msec, ev->code, ev->a);
+		break;
 	}
+}
 
-	if (b == BTN_MIDDLE && pressed && was_right && !mura.chord.activated) {
-		click_cancel();
-		stop_select();
-		mura.chord.activated = true;
-		mura.chord.scrolling = true;
-		mura.chord.scroll_cursor_dir = -1;
-		update_mode_cursor();
-		scroll_stop();
+static void
+replay_finish(void)
+{
+	double secs = (now_nsec() - mura.input.replay_start) / 1e9;
 
-		/* start drag-to-scroll tracking (if enabled) */
-		if (scroll_drag_mode) {
-			if (cursor_position(&x, &y)) {
-				mura.chord.scroll_drag_last_x = x;
-				mura.chord.scroll_drag_last_y = y;
-			}
-			if (!mura.chord.scroll_drag_timer)
-				mura.chord.scroll_drag_timer = wl_event_loop_add_timer(mura.evloop, scroll_drag_tick, NULL);
-			if (mura.chord.scroll_drag_timer)
-				wl_event_source_timer_update(mura.chord.scroll_drag_timer, timerms);
-		}
+	fprintf(stderr, "replayed %zu events in %.3f s (%s)\n",
+	        mura.input.nevents, secs, mura.input.fast ? "fast" : "timed");
+	perf_report(stderr);
 
-		if (debugscroll)
-			fprintf(stderr, "[scroll] start\n");
-		return;
-	}
+	mura.input.replaying = false;
+	terminate();
+}
 
-	if (b == BTN_MIDDLE && !pressed && was_left && ! mura.chord.activated &&
-	    !mura.chord.selecting && !acme_passthrough) {
-		click_cancel();
-		stop_select();
-		mura.chord.activated = true;
-		mura.chord.moving = true;
-		update_mode_cursor();
+/* timed replays deliver each event at its recorded offset, fast ones deliver
+ * everything that shares a timestamp and let the loop run for a millisecond so
+ * the easing timers still see the workload */
+static int
+replay_tick(void *data)
+{
+	uint64_t elapsed;
+	uint32_t msec;
+	int delay;
 
-		/* get starting pos to be used for easing calculation*/
-		if(mura.focused && cursor_position(&x, &y)){
-			struct swc_rectangle geometry;
-			if(swc_window_get_geometry(mura.focused, &geometry)){
-				mura.chord.move_start_win_x = geometry.x;
-				mura.chord.move_start_win_y = geometry.y;
-				mura.chord.move_start_cursor_x = x;
-				mura.chord.move_start_cursor_y = y;
-			}
-		}
+	(void)data;
 
-		/* auto-scroll timer for scroll durin win move */
-		if(!mura.chord.move_scroll_timer)
-			mura.chord.move_scroll_timer = wl_event_loop_add_timer(mura.evloop, move_scroll_tick, NULL);
-		if(mura.chord.move_scroll_timer)
-			wl_event_source_timer_update(mura.chord.move_scroll_timer, timerms);
+	elapsed = (now_nsec() - mura.input.replay_start) / 1000000;
+	msec = mura.input.events[mura.input.next].msec;
 
-		/* forward the release so clients dont see stuck */
-		swc_pointer_send_button(time, b, state);
+	mura.input.feeding = true;
+	while (mura.input.next < mura.input.nevents) {
+		const struct input_event *ev = &mura.input.events[mura.input.next];
 
-		return;
+		if (mura.input.fast ? ev->msec != msec : ev->msec > elapsed)
+			break;
+		replay_event(ev);
+		mura.input.next++;
 	}
+	mura.input.feeding = false;
 
-	if (b == BTN_LEFT && !pressed && mura.chord.moving == true) {
-		mura.chord.moving = false;
-		update_mode_cursor();
+	if (mura.input.next == mura.input.nevents) {
+		replay_finish();
+		return 0;
+	}
 
-		/* stop timer */
-		if(mura.chord.move_scroll_timer){
-			wl_event_source_remove(mura.chord.move_scroll_timer);
-			mura.chord.move_scroll_timer = NULL;
-		}
+	delay = 1;
+	if (!mura.input.fast && mura.input.events[mura.input.next].msec > elapsed + 1)
+		delay = (int)(mura.input.events[mura.input.next].msec - elapsed);
+	wl_event_source_timer_update(mura.input.replay_timer, delay);
+	return 0;
+}
 
-		if (!mura.chord.left && !mura.chord.middle && !mura.chord.right)
-			mura.chord.activated = false;
+static bool
+replay_start(void)
+{
+	if (mura.input.nevents == 0) {
+		fprintf(stderr, "input trace is empty\n");
+		return false;
+	}
 
-		/* forward the release so clients dont see stuk */
-		swc_pointer_send_button(time, b, state);
+	mura.input.replay_timer = wl_event_loop_add_timer(mura.evloop, replay_tick, NULL);
+	if (!mura.input.replay_timer)
+		return false;
 
-		return;
-	}
+	mura.input.replaying = true;
+	mura.input.replay_start = now_nsec();
+	wl_event_source_timer_update(mura.input.replay_timer, 1);
+	return true;
+}
 
-	if (b == BTN_MIDDLE && !pressed && was_right && ! mura.chord.activated && !mura.chord.selecting) {
-		click_cancel();
-		stop_select();
-		mura.chord.activated = true;
-		mura.chord.resize = true;
-		update_mode_cursor();
+static void
+quit(void *data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)data;
+	(void)time;
+	(void)value;
+	(void)state;
+	terminate();
+}
 
-		if (mura.focused)
-			/* bottom right */
-			swc_window_begin_resize(mura.focused, SWC_WINDOW_EDGE_RIGHT | SWC_WINDOW_EDGE_BOTTOM);
+static void
+sig(int s)
+{
+	(void)s;
+	terminate();
+}
 
+/* the control socket: rio's wsys as lines. every command gets one reply
+ * line, "ok" with what was read or "error" with why. the writes between
+ * begin and commit are checked first and then applied all at once, in one
+ * dispatch and so in one frame, and get a single reply. README.md lists the
+ * paths */
+#define CONTROL_LINE 4096
+#define CONTROL_BATCH 65536
+/* replies waiting to be sent. no more commands are run until they fit, so a
+ * client that stops reading stalls itself and never mura */
+#define CONTROL_OUT (4 * CONTROL_LINE)
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
 
-		/* forward the middle release so clients don't see it stuck */
-		swc_pointer_send_button(time, b, state);
+enum control_kind {
+	CONTROL_GEOMETRY,
+	CONTROL_FOCUS,
+	CONTROL_JUMP,
+	CONTROL_CLOSE,
+	CONTROL_NEW,
+	CONTROL_SCROLL,
+	CONTROL_ZOOM,
+};
 
-		return;
-	}
+struct control_op {
+	uint8_t kind;
+	uint32_t id;
+	int64_t x, y;
+	uint32_t width, height;
+	float zoom;
+};
 
-	if (b == BTN_RIGHT && !pressed && mura.chord.resize == true) {
-		mura.chord.resize = false;
-		update_mode_cursor();
+struct control_client {
+	int fd;
+	struct wl_event_source *source;
+	struct wl_list link;
+	char buf[CONTROL_LINE];
+	size_t len;
+	char out[CONTROL_OUT];
+	size_t out_len;
+	bool overflow; /* the rest of an overlong line is skipped */
+	bool eof;      /* the client is done sending */
+	bool dead;     /* a reply could not be sent */
+	bool batching;
+	struct control_op *ops;
+	size_t nops, cap;
+	/* the first bad line of the batch, which is then dropped whole */
+	size_t lines, bad_line;
+	char bad[96];
+};
 
-		if (mura.focused)
-			swc_window_end_resize(mura.focused);
+static void
+control_reply(struct control_client *c, const char *fmt, ...)
+{
+	char line[CONTROL_LINE];
+	va_list ap;
+	int n;
 
-		if (!mura.chord.left && !mura.chord.middle && !mura.chord.right)
-			mura.chord.activated = false;
+	if (c->dead)
+		return;
+	va_start(ap, fmt);
+	n = vsnprintf(line, sizeof(line) - 1, fmt, ap);
+	va_end(ap);
+	if (n < 0)
+		return;
+	if ((size_t)n > sizeof(line) - 2)
+		n = sizeof(line) - 2;
+	line[n++] = '\n';
+	/* control_run leaves room for one line */
+	memcpy(c->out + c->out_len, line, (size_t)n);
+	c->out_len += (size_t)n;
+}
 
-		/* let clients see the release we swallowed */
-		swc_pointer_send_button(time, b, state);
+/* one send for all the replies of a read, a send per "ok" costs the client a
+ * socket buffer each */
+static void
+control_flush(struct control_client *c)
+{
+	ssize_t n;
 
+	if (c->dead || !c->out_len)
+		return;
+	n = send(c->fd, c->out, c->out_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (n < 0) {
+		if (errno != EAGAIN && errno != EINTR)
+			c->dead = true;
 		return;
 	}
+	c->out_len -= (size_t)n;
+	memmove(c->out, c->out + n, c->out_len);
+}
 
-	if (b == BTN_MIDDLE && pressed && was_left && !mura.chord.activated) {
-		click_cancel();
-		stop_select();
-
-		if (mura.focused) {
-			struct window *w;
-			wl_list_for_each(w, &mura.windows, link) {
-				if (w->swc == mura.focused) {
-					#if defined(STICKY)
-						w->sticky = !w->sticky;
-					#elif defined(FULLSCREEN)
-						w->sticky = !w->sticky;
-						swc_window_set_fullscreen(mura.focused, mura.current_screen->swc);
-					#elif defined(JUMP)
-						bool state = focus_center;
-						focus_center = true;
-						mura.chord.jumping = true;
-						struct window *closest = NULL;
-						struct window *n;
-						struct swc_rectangle ngeom;
+static struct window *
+control_window(uint32_t id)
+{
+	struct window *w;
 
-						int32_t x = 0, y = 0;
-						cursor_position_raw(&x, &y);
-						int64_t mindist = INT64_MAX;
-						wl_list_for_each(n, &mura.windows, link) {
-							if (!n->swc)
-								continue;
+	wl_list_for_each(w, &mura.windows, link) {
+		if (w->id == id)
+			return wlist_listable(w) ? w : NULL;
+	}
+	return NULL;
+}
 
-							if (!swc_window_get_geometry(n->swc, &ngeom))
-								continue;
+/* "/wsys/<id>/<file>", with file pointing into path */
+static struct window *
+control_path(const char *path, const char **file)
+{
+	char *end;
+	unsigned long id;
+
+	if (strncmp(path, "/wsys/", 6) != 0)
+		return NULL;
+	id = strtoul(path + 6, &end, 10);
+	if (end == path + 6 || *end != '/' || id > UINT32_MAX)
+		return NULL;
+	*file = end + 1;
+	return control_window((uint32_t)id);
+}
 
-							/* makes a cool switcher thingy */
-							if (n->swc == mura.focused)
-								continue;
+static bool
+control_rect(const char *arg, struct control_op *op)
+{
+	long long x, y;
+	unsigned width, height;
+	char extra;
 
-							int64_t dx = (int64_t)x - (int64_t)ngeom.x;
-							int64_t dy = (int64_t)y - (int64_t)ngeom.y;
+	if (sscanf(arg, "%lld %lld %u %u %c", &x, &y, &width, &height, &extra) != 4 ||
+	    x < INT32_MIN || x > INT32_MAX || y < INT32_MIN || y > INT32_MAX ||
+	    width == 0 || height == 0 || width > 32767 || height > 32767)
+		return false;
+	op->x = x;
+	op->y = y;
+	op->width = width;
+	op->height = height;
+	return true;
+}
 
-							/* fuck sqrt() */
-							int64_t dist = dx*dx + dy*dy;
+/* swc places windows in 32 bits of screen, the plane has 64 */
+static bool
+control_fits(const struct control_op *op)
+{
+	int64_t x = op->x + mura.camera.x, y = op->y + mura.camera.y;
 
-							if (dist < mindist) {
-								closest = n;
-								mindist = dist;
-							}
-						}
+	return x >= INT32_MIN && x <= INT32_MAX && y >= INT32_MIN && y <= INT32_MAX;
+}
 
-						if (closest != NULL)
-							focus_window(closest->swc, "jump");
+/* a write checked against the windows there are now, nothing happens yet */
+static const char *
+control_parse(char *path, char *arg, struct control_op *op)
+{
+	struct window *w;
+	const char *file;
+	long long x, y;
+	char extra;
+
+	memset(op, 0, sizeof(*op));
+	if (strcmp(path, "/scroll") == 0) {
+		if (sscanf(arg, "%lld %lld %c", &x, &y, &extra) != 2 ||
+		    x < INT32_MIN || x > INT32_MAX || y < INT32_MIN || y > INT32_MAX)
+			return "scroll wants x y";
+		op->kind = CONTROL_SCROLL;
+		op->x = x;
+		op->y = y;
+		return NULL;
+	}
+	if (strcmp(path, "/zoom") == 0) {
+		if (!enable_zoom)
+			return "zoom is off in config.h";
+		if (sscanf(arg, "%f %c", &op->zoom, &extra) != 1 || !(op->zoom >= 0.25f && op->zoom <= 4.0f))
+			return "zoom wants a number from 0.25 to 4";
+		op->kind = CONTROL_ZOOM;
+		return NULL;
+	}
+	if (strcmp(path, "/wsys/new") == 0) {
+		if (!control_rect(arg, op))
+			return "new wants x y width height";
+		if (!control_fits(op))
+			return "too far from the screen";
+		op->kind = CONTROL_NEW;
+		return NULL;
+	}
+	if (!(w = control_path(path, &file)))
+		return "no such window";
+	op->id = w->id;
+	if (strcmp(file, "geometry") == 0) {
+		if (!control_rect(arg, op))
+			return "geometry wants x y width height";
+		if (!control_fits(op))
+			return "too far from the screen";
+		op->kind = CONTROL_GEOMETRY;
+	} else if (strcmp(file, "ctl") == 0) {
+		if (strcmp(arg, "focus") == 0)
+			op->kind = CONTROL_FOCUS;
+		else if (strcmp(arg, "jump") == 0)
+			op->kind = CONTROL_JUMP;
+		else if (strcmp(arg, "close") == 0)
+			op->kind = CONTROL_CLOSE;
+		else
+			return "ctl takes focus, jump or close";
+	} else if (strcmp(file, "title") == 0 || strcmp(file, "app_id") == 0) {
+		return "read only";
+	} else {
+		return "no such file";
+	}
+	return NULL;
+}
 
-						mura.chord.jumping = false;
-						focus_center = state;
-					#endif
-					break;
-				}
-			}
-		}
+/* plane coordinates in, screen coordinates out. a /scroll earlier in the
+ * same batch can still move a checked position off the 32 bits, it is
+ * clamped rather than wrapped */
+static void
+control_apply(const struct control_op *op)
+{
+	struct swc_rectangle geometry;
+	struct window *w;
 
-		mura.chord.activated = true;
-		swc_pointer_send_button(time, b, state);
+	switch (op->kind) {
+	case CONTROL_SCROLL:
+		pan_to(op->x, op->y);
+		return;
+	case CONTROL_ZOOM:
+		mura.chord.zoom_target = op->zoom;
+		swc_set_zoom(op->zoom);
+		camera_changed();
+		return;
+	case CONTROL_NEW:
+		geometry.x = (int32_t)clamp64(op->x + mura.camera.x, INT32_MIN, INT32_MAX);
+		geometry.y = (int32_t)clamp64(op->y + mura.camera.y, INT32_MIN, INT32_MAX);
+		geometry.width = op->width;
+		geometry.height = op->height;
+		spawn_term_select(&geometry);
 		return;
 	}
 
-	if (b == BTN_MIDDLE && !pressed && mura.chord.scrolling) {
+	/* an earlier op in the batch may have closed it */
+	if (!(w = control_window(op->id)))
 		return;
+	switch (op->kind) {
+	case CONTROL_GEOMETRY:
+		geometry.x = (int32_t)clamp64(op->x + mura.camera.x, INT32_MIN, INT32_MAX);
+		geometry.y = (int32_t)clamp64(op->y + mura.camera.y, INT32_MIN, INT32_MAX);
+		geometry.width = op->width;
+		geometry.height = op->height;
+		swc_window_set_geometry(w->swc, &geometry);
+		wlist_changed(w, WLIST_GEOMETRY);
+		break;
+	case CONTROL_FOCUS:
+		focus_window(w->swc, "control");
+		break;
+	case CONTROL_JUMP:
+		jump_to(w, "control");
+		break;
+	case CONTROL_CLOSE:
+		swc_window_close(w->swc);
+		break;
 	}
+}
 
-	if (pressed && is_lr && !mura.chord.selecting) {
-		bool other_down = (b == BTN_LEFT) ? was_right : was_left;
-
-		/* stop auto-scrolling on any clics */
-		if (mura.chord.auto_scrolling) {
-			mura.chord.auto_scrolling = false;
-			scroll_stop();
-		}
-
-		/* only left button focuses windows */
-		if (b == BTN_LEFT && !other_down && cursor_position(&x, &y)) {
-			struct swc_window *target = swc_window_at(x, y);
-
-			if (target)
-				focus_window(target, "click");
+static void
+control_read_file(struct control_client *c, const char *path)
+{
+	struct swc_rectangle geometry;
+	struct window *w;
+	const char *file, *s;
+	char list[CONTROL_LINE], clean[CONTROL_LINE];
+	size_t n = 0;
+
+	if (strcmp(path, "/wsys") == 0 || strcmp(path, "/wsys/") == 0) {
+		list[0] = '\0';
+		wl_list_for_each_reverse(w, &mura.windows, link) {
+			if (!wlist_listable(w))
+				continue;
+			n += (size_t)snprintf(list + n, sizeof(list) - n, " %" PRIu32, w->id);
+			/* a long list is cut, the newest windows are at the end */
+			if (n >= sizeof(list) - 12)
+				break;
 		}
+		control_reply(c, "ok%s", list);
+		return;
 	}
-
-	if(mura.chord.left && mura.chord.right && !mura.chord.activated && !acme_passthrough){
-		click_cancel();
-		mura.chord.activated = true;
-		if(cursor_position(&x, &y)){
-			mura.chord.selecting = true;
-			update_mode_cursor();
-			mura.chord.start_x = x;
-			mura.chord.start_y = y;
-			mura.chord.cur_x = x;
-			mura.chord.cur_y = y;
-			swc_overlay_set_box(x, y, x, y, select_box_color, select_box_border);
-			if(!mura.chord.timer)
-				mura.chord.timer = wl_event_loop_add_timer(mura.evloop, select_tick, NULL);
-			if(mura.chord.timer)
-				wl_event_source_timer_update(mura.chord.timer, timerms);
+	if (strcmp(path, "/scroll") == 0) {
+		control_reply(c, "ok %" PRId64 " %" PRId64, mura.camera.x, mura.camera.y);
+		return;
+	}
+	if (strcmp(path, "/zoom") == 0) {
+		control_reply(c, "ok %.3f", swc_get_zoom());
+		return;
+	}
+	if (!(w = control_path(path, &file))) {
+		control_reply(c, "error no such window");
+		return;
+	}
+	if (strcmp(file, "geometry") == 0) {
+		if (!swc_window_get_geometry(w->swc, &geometry)) {
+			control_reply(c, "error no geometry yet");
+			return;
 		}
+		control_reply(c, "ok %" PRId64 " %" PRId64 " %" PRIu32 " %" PRIu32,
+		              geometry.x - mura.camera.x, geometry.y - mura.camera.y,
+		              geometry.width, geometry.height);
+	} else if (strcmp(file, "title") == 0 || strcmp(file, "app_id") == 0) {
+		s = strcmp(file, "title") == 0 ? w->swc->title : w->swc->app_id;
+		/* one reply is one line */
+		for (n = 0; s && s[n] && n < sizeof(clean) - 1; n++)
+			clean[n] = s[n] == '\n' || s[n] == '\r' ? ' ' : s[n];
+		clean[n] = '\0';
+		control_reply(c, "ok %s", clean);
+	} else if (strcmp(file, "ctl") == 0) {
+		control_reply(c, "ok %d %s %s", (int)w->pid, w->swc == mura.focused ? "focused" : "unfocused",
+		              w->hidden_for_spawn ? "hidden" : "visible");
+	} else {
+		control_reply(c, "error no such file");
 	}
+}
 
-	/* while a chord is active swallow left/right events so they don't go to clients */
-	if(is_chord_button && mura.chord.activated && !mura.chord.selecting){
-		bool was_scrolling = mura.chord.scrolling;
-		if (!mura.chord.right)
-			mura.chord.scrolling = false;
-		if (was_scrolling && !mura.chord.scrolling)
-			update_mode_cursor();
-		if (!mura.chord.scrolling) {
-			if (debugscroll)
-				fprintf(stderr, "[scroll] stop\n");
-			scroll_stop();
-		}
-		if(!mura.chord.left && !mura.chord.middle && !mura.chord.right)
-			mura.chord.activated = false;
+static void
+control_command(struct control_client *c, char *line)
+{
+	struct control_op op, *ops;
+	const char *err;
+	char *path, *arg;
+	size_t cap;
+
+	while (*line == ' ' || *line == '\t')
+		line++;
+	if (!*line || *line == '#')
 		return;
-	}
 
-	if (b == BTN_MIDDLE) {
-		if (mura.chord.moving)
+	if (strcmp(line, "begin") == 0) {
+		if (c->batching) {
+			control_reply(c, "error already in a batch");
 			return;
-		swc_pointer_send_button(time, b, state);
+		}
+		c->batching = true;
+		c->nops = c->lines = c->bad_line = 0;
 		return;
 	}
-
-	/* pass normal clicks through to clients */
-	if(is_lr && pressed && !mura.chord.selecting){
-		bool other_down = (b == BTN_LEFT) ? was_right : was_left;
-		if(other_down){
-			/* chord will activate via the block above */
-		} else if(!mura.chord.click.pending) {
-			mura.chord.click.pending = true;
-			mura.chord.click.forwarded = false;
-			mura.chord.click.button = b;
-			mura.chord.click.time = time;
-			if(!mura.chord.click_timer)
-				mura.chord.click_timer = wl_event_loop_add_timer(mura.evloop, click_timeout, NULL);
-			if(mura.chord.click_timer)
-				wl_event_source_timer_update(mura.chord.click_timer, chord_click_timeout_ms);
+	if (strcmp(line, "commit") == 0 || strcmp(line, "abort") == 0) {
+		if (!c->batching) {
+			control_reply(c, "error not in a batch");
 			return;
 		}
+		c->batching = false;
+		if (line[0] == 'a')
+			control_reply(c, "ok");
+		else if (c->bad_line)
+			control_reply(c, "error line %zu: %s", c->bad_line, c->bad);
+		else {
+			for (size_t i = 0; i < c->nops; i++)
+				control_apply(&c->ops[i]);
+			control_reply(c, "ok %zu", c->nops);
+		}
+		return;
 	}
 
-	if(is_lr && !pressed && !mura.chord.selecting){
-		if(mura.chord.click.pending && mura.chord.click.button == b){
-			if(!mura.chord.click.forwarded){
-				swc_pointer_send_button(mura.chord.click.time, mura.chord.click.button,
-				                        WL_POINTER_BUTTON_STATE_PRESSED);
+	path = line;
+	if (strncmp(line, "read ", 5) == 0) {
+		path = line + 5;
+		if (c->batching) {
+			c->lines++;
+			if (!c->bad_line) {
+				c->bad_line = c->lines;
+				snprintf(c->bad, sizeof(c->bad), "a batch only writes");
 			}
-			swc_pointer_send_button(time, b, WL_POINTER_BUTTON_STATE_RELEASED);
-			click_cancel();
 			return;
 		}
-		swc_pointer_send_button(time, b, WL_POINTER_BUTTON_STATE_RELEASED);
+		control_read_file(c, path);
+		return;
+	}
+	if (strncmp(line, "write ", 6) != 0) {
+		err = "commands are read, write, begin, commit and abort";
+		goto error;
+	}
+	path = line + 6;
+	if ((arg = strchr(path, ' ')))
+		*arg++ = '\0';
+	else
+		arg = path + strlen(path);
+
+	err = control_parse(path, arg, &op);
+	if (!c->batching) {
+		if (err)
+			goto error;
+		control_apply(&op);
+		control_reply(c, "ok");
 		return;
 	}
 
-	if(b == BTN_RIGHT && !pressed && mura.chord.selecting){
-		int32_t x1, y1, x2, y2;
-		uint32_t outer_w, outer_h;
-		uint32_t bw = outer_border_width + inner_border_width;
-
-		if(!cursor_position(&x, &y)){
-			x = mura.chord.cur_x;
-			y = mura.chord.cur_y;
+	c->lines++;
+	if (c->bad_line)
+		return;
+	if (!err && c->nops == CONTROL_BATCH)
+		err = "batch too long";
+	if (!err && c->nops == c->cap) {
+		cap = c->cap ? c->cap * 2 : 64;
+		if (!(ops = realloc(c->ops, cap * sizeof(*ops))))
+			err = "out of memory";
+		else {
+			c->ops = ops;
+			c->cap = cap;
 		}
-		stop_select();
+	}
+	if (err) {
+		c->bad_line = c->lines;
+		snprintf(c->bad, sizeof(c->bad), "%s", err);
+		return;
+	}
+	c->ops[c->nops++] = op;
+	return;
+
+error:
+	if (c->batching) {
+		c->lines++;
+		if (!c->bad_line) {
+			c->bad_line = c->lines;
+			snprintf(c->bad, sizeof(c->bad), "%s", err);
+		}
+		return;
+	}
+	control_reply(c, "error %s", err);
+}
 
-		x1 = mura.chord.start_x < x ? mura.chord.start_x : x;
-		y1 = mura.chord.start_y < y ? mura.chord.start_y : y;
-		x2 = mura.chord.start_x < x ? x : mura.chord.start_x;
-		y2 = mura.chord.start_y < y ? y : mura.chord.start_y;
-		outer_w = (uint32_t)abs(x2 - x1);
-		outer_h = (uint32_t)abs(y2 - y1);
-		if(outer_w < (50 + 2 * bw))
-			outer_w = 50 + 2 * bw;
-		if(outer_h < (50 + 2 * bw))
-			outer_h = 50 + 2 * bw;
+static void
+control_close(struct control_client *c)
+{
+	wl_event_source_remove(c->source);
+	wl_list_remove(&c->link);
+	close(c->fd);
+	free(c->ops);
+	free(c);
+}
 
-		/* swc_window_set_*  content geom */
-		geometry.x = x1 + (int32_t)bw;
-		geometry.y = y1 + (int32_t)bw;
-		geometry.width = outer_w > 2 * bw ? outer_w - 2 * bw : 1;
-		geometry.height = outer_h > 2 * bw ? outer_h - 2 * bw : 1;
-		spawn_term_select(&geometry);
-		printf("spawned terminal at %d,%d %ux%u\n", geometry.x, geometry.y, geometry.width, geometry.height);
+/* runs the whole lines read so far, while their replies still fit */
+static void
+control_run(struct control_client *c)
+{
+	char *line = c->buf, *nl;
+
+	while (c->out_len + CONTROL_LINE <= sizeof(c->out) && (nl = strchr(line, '\n'))) {
+		*nl = '\0';
+		if (nl > line && nl[-1] == '\r')
+			nl[-1] = '\0';
+		if (c->overflow)
+			c->overflow = false;
+		else
+			control_command(c, line);
+		line = nl + 1;
 	}
+	c->len -= (size_t)(line - c->buf);
+	memmove(c->buf, line, c->len + 1);
+	if (c->len == sizeof(c->buf) - 1 && !strchr(c->buf, '\n') &&
+	    c->out_len + CONTROL_LINE <= sizeof(c->out)) {
+		c->len = 0;
+		c->buf[0] = '\0';
+		if (!c->overflow)
+			control_reply(c, "error line too long");
+		c->overflow = true;
+	}
+}
 
-	if(!is_lr){
-		swc_pointer_send_button(time, b, state);
+static int
+control_read(int fd, uint32_t mask, void *data)
+{
+	struct control_client *c = data;
+	uint64_t start = perf_start();
+	ssize_t n;
+
+	if (mask & WL_EVENT_WRITABLE)
+		control_flush(c);
+	/* nothing more is read while replies wait, and a hangup still leaves
+	 * what was sent before it to read */
+	if ((mask & (WL_EVENT_READABLE | WL_EVENT_HANGUP)) && !c->out_len && !c->eof && c->len < sizeof(c->buf) - 1) {
+		n = read(fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len);
+		if (n > 0) {
+			c->len += (size_t)n;
+			c->buf[c->len] = '\0';
+		} else if (n == 0 || (errno != EAGAIN && errno != EINTR))
+			c->eof = true;
+	}
+	/* a full reply buffer stops control_run() with lines left, they run as
+	 * soon as the replies are out, or once the socket has room for them */
+	do {
+		control_run(c);
+		control_flush(c);
+	} while (!c->dead && !c->out_len && strchr(c->buf, '\n'));
+
+	if (c->dead || (c->eof && !c->out_len && !strchr(c->buf, '\n')))
+		control_close(c);
+	else
+		wl_event_source_fd_update(c->source, c->out_len ? WL_EVENT_WRITABLE :
+		                          c->eof ? 0 : WL_EVENT_READABLE);
+	perf_add(PERF_CONTROL, start);
+	return 0;
+}
+
+static int
+control_accept(int fd, uint32_t mask, void *data)
+{
+	struct control_client *c;
+	int client;
+
+	(void)mask;
+	(void)data;
+	if ((client = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) < 0)
+		return 0;
+	if (!(c = calloc(1, sizeof(*c)))) {
+		close(client);
+		return 0;
+	}
+	c->fd = client;
+	c->source = wl_event_loop_add_fd(mura.evloop, client, WL_EVENT_READABLE, control_read, c);
+	if (!c->source) {
+		close(client);
+		free(c);
+		return 0;
+	}
+	wl_list_insert(&mura.control.clients, &c->link);
+	return 0;
+}
+
+/* $XDG_RUNTIME_DIR/<wayland socket>.mura, also in MURA_CTL for children */
+static void
+control_start(const char *sock)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	int fd;
+
+	if (!dir)
+		return;
+	if ((size_t)snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s.mura", dir, sock) >=
+	    sizeof(addr.sun_path))
+		return;
+	unlink(addr.sun_path);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return;
+	if (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0 ||
+	    bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+		fprintf(stderr, "cannot listen on %s\n", addr.sun_path);
+		close(fd);
+		return;
+	}
+	mura.control.source = wl_event_loop_add_fd(mura.evloop, fd, WL_EVENT_READABLE, control_accept, NULL);
+	if (!mura.control.source) {
+		close(fd);
+		unlink(addr.sun_path);
 		return;
 	}
+	mura.control.fd = fd;
+	snprintf(mura.control.path, sizeof(mura.control.path), "%s", addr.sun_path);
+	setenv("MURA_CTL", addr.sun_path, 1);
+}
 
-	if(!mura.chord.left && !mura.chord.middle && !mura.chord.right)
-		mura.chord.activated = false;
+static void
+control_stop(void)
+{
+	struct control_client *c, *tmp;
+
+	wl_list_for_each_safe(c, tmp, &mura.control.clients, link)
+		control_close(c);
+	if (!mura.control.source)
+		return;
+	wl_event_source_remove(mura.control.source);
+	close(mura.control.fd);
+	unlink(mura.control.path);
 }
 
+/* wl_display_run(), plus a pass over the pointer after every dispatch.
+ * the wait happens in poll() here rather than inside the dispatch, so the
+ * dispatch histogram only holds time mura was busy */
 static void
-quit(void *data, uint32_t time, uint32_t value, uint32_t state)
+run(void)
 {
-	(void)data;
-	(void)time;
-	(void)value;
-	(void)state;
-	wl_display_terminate(mura.display);
+	struct pollfd pfd = { .fd = wl_event_loop_get_fd(mura.evloop), .events = POLLIN };
+	uint64_t start;
+
+	while (running) {
+		wl_event_loop_dispatch_idle(mura.evloop);
+		wl_display_flush_clients(mura.display);
+		if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+			break;
+
+		start = now_nsec();
+		mura.prof.slow_seen = false;
+		wl_event_loop_dispatch(mura.evloop, 0);
+		pointer_motion();
+		map_check();
+		prof_close(now_nsec());
+		mura.tele.current = NULL;
+		perf_add(PERF_DISPATCH, start);
+	}
 }
 
 static void
-sig(int s)
+usage(void)
 {
-	(void)s;
-	wl_display_terminate(mura.display);
+	fprintf(stderr, "usage: mura [-r trace] [-p trace [-f]] [-t ring]\n");
+	exit(1);
 }
 
 int
-main(void)
+main(int argc, char *argv[])
 {
 	struct wl_event_loop *evloop;
 	const char *sock;
+	const char *record_path = NULL, *replay_path = NULL, *ring_path = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "r:p:ft:")) != -1) {
+		switch (c) {
+		case 'r':
+			record_path = optarg;
+			break;
+		case 'p':
+			replay_path = optarg;
+			break;
+		case 'f':
+			mura.input.fast = true;
+			break;
+		case 't':
+			ring_path = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc || (mura.input.fast && !replay_path))
+		usage();
+	if (ring_path && !trace_start(ring_path))
+		return 1;
+
+	if (replay_path && !replay_load(replay_path))
+		return 1;
+
+	/* fork the spawn helper while mura is still small */
+	mura.spawner.fd = -1;
+	spawner_start();
 
 	wl_list_init(&mura.windows);
 	wl_list_init(&mura.screens);
-	wl_list_init(&scrollpos_resources);
+	wl_list_init(&mura.gesture.devices);
+	wl_list_init(&mura.spawns);
+	for (int i = 0; i < PID_BUCKETS; i++) {
+		wl_list_init(&mura.window_pids[i]);
+		wl_list_init(&mura.procs[i]);
+	}
+	wl_list_init(&mura.tele.surfaces);
+	wl_list_init(&mura.camera.clients);
+	wl_list_init(&mura.wlist.clients);
+	wl_list_init(&mura.wlist.dirty);
+	wl_list_init(&mura.control.clients);
+	mura.plane.stale = true;
 
 	mura.current_screen = NULL;
 	mura.display = wl_display_create();
@@ -1426,12 +4941,20 @@ main(void)
 	evloop = wl_display_get_event_loop(mura.display);
 	mura.evloop = evloop;
 
+	if (mura.spawner.fd >= 0)
+		mura.spawner.source = wl_event_loop_add_fd(evloop, mura.spawner.fd,
+		                                           WL_EVENT_READABLE, spawner_dispatch, NULL);
+
 	if(!swc_initialize(mura.display, evloop, &manager)){
 		fprintf(stderr, "cannot initialize swc\n");
 		return 1;
 	}
 
-	wl_global_create(mura.display, &mura_scroll_interface, 1, NULL, bind_scrollpos);
+	wl_global_create(mura.display, &mura_scroll_interface, 3, NULL, bind_scrollpos);
+	wl_global_create(mura.display, &mura_stat_interface, 1, NULL, bind_stat);
+	wl_global_create(mura.display, &mura_top_interface, 1, NULL, bind_top);
+	wl_global_create(mura.display, &mura_windows_interface, 2, NULL, bind_windows);
+	mura.prof.logger = wl_display_add_protocol_logger(mura.display, prof_request, NULL);
 
 	maybe_enable_nein_cursor_theme();
 
@@ -1455,14 +4978,50 @@ main(void)
 
 	printf("%s\n", sock);
 	setenv("WAYLAND_DISPLAY", sock, 1);
+	if (control_socket)
+		control_start(sock);
+
+	pool_fill();
 
 	signal(SIGTERM, sig);
 	signal(SIGINT, sig);
 
-	wl_display_run(mura.display);
+	if (record_path && !record_open(record_path))
+		return 1;
+	if (replay_path && !replay_start())
+		return 1;
+
+	run();
+
+	if (mura.input.record)
+		fclose(mura.input.record);
+	free(mura.input.events);
+	proc_clear();
+	if (mura.prof.logger)
+		wl_protocol_logger_destroy(mura.prof.logger);
+	trace_close();
+	control_stop();
 
 	swc_finalize();
+	if (mura.gesture.monitor) {
+		if (mura.gesture.monitor_source)
+			wl_event_source_remove(mura.gesture.monitor_source);
+		udev_monitor_unref(mura.gesture.monitor);
+	}
+	if (mura.gesture.li) {
+		struct gesture_device *gd, *tmp;
+
+		wl_list_for_each_safe(gd, tmp, &mura.gesture.devices, link) {
+			free(gd->syspath);
+			free(gd);
+		}
+		libinput_unref(mura.gesture.li);
+	}
 	wl_display_destroy(mura.display);
+	if (mura.camera.page) {
+		munmap(mura.camera.page, sizeof(*mura.camera.page));
+		close(mura.camera.page_fd);
+	}
 
 	return 0;
 }
@@ -0,0 +1,472 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "spawner.h"
+
+extern char **environ;
+
+enum spawn_msg_type {
+	MSG_SPAWN = 1,
+	MSG_PARENTS,
+	MSG_TOKEN,
+};
+
+/* request layout: the header, then argc strings and envc strings, each NUL
+ * terminated, packed back to back. MSG_PARENTS and MSG_TOKEN have no
+ * strings, the pid is in token */
+struct spawn_msg {
+	uint16_t type;
+	uint16_t argc, envc;
+	uint32_t token;
+};
+
+static int sigchld_pipe[2] = { -1, -1 };
+
+static void
+helper_sigchld(int s)
+{
+	int saved = errno;
+
+	(void)s;
+	if (write(sigchld_pipe[1], "", 1) < 0) {
+		/* pipe full, a wakeup is already pending */
+	}
+	errno = saved;
+}
+
+static void
+helper_send(int fd, uint32_t type, uint32_t token, pid_t pid, int status)
+{
+	struct spawn_event ev = { type, token, pid, status };
+
+	send(fd, &ev, sizeof(ev), 0);
+}
+
+/* children are matched back to the token they were started with */
+struct child {
+	pid_t pid;
+	uint32_t token;
+};
+
+static struct child *children;
+static size_t nchildren, children_cap;
+
+static void
+helper_reap(int fd)
+{
+	pid_t pid;
+	int status;
+	size_t i;
+
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		uint32_t token = 0;
+
+		for (i = 0; i < nchildren; i++) {
+			if (children[i].pid == pid) {
+				token = children[i].token;
+				children[i] = children[--nchildren];
+				break;
+			}
+		}
+		helper_send(fd, SPAWN_EXITED, token, pid, status);
+	}
+}
+
+static char **
+helper_environ(char **extra, uint16_t n)
+{
+	size_t count = 0, i, j;
+	char **env;
+
+	while (environ[count])
+		count++;
+
+	env = calloc(count + n + 1, sizeof(*env));
+	if (!env)
+		return NULL;
+
+	for (i = 0; i < count; i++)
+		env[i] = environ[i];
+
+	/* requested variables replace inherited ones of the same name */
+	for (j = 0; j < n; j++) {
+		size_t len = strcspn(extra[j], "=");
+
+		for (i = 0; i < count; i++) {
+			if (strncmp(env[i], extra[j], len) == 0 && env[i][len] == '=')
+				break;
+		}
+		env[i] = extra[j];
+		if (i == count)
+			count++;
+	}
+	return env;
+}
+
+static void
+helper_spawn(int fd, char *buf, size_t len)
+{
+	struct spawn_msg *msg = (struct spawn_msg *)buf;
+	char *argv[64], *extra[16], **env, *p, *end = buf + len;
+	posix_spawnattr_t attr;
+	sigset_t none, defaults;
+	pid_t pid;
+	int i, err;
+
+	if (len < sizeof(*msg) || msg->argc == 0 || msg->argc >= 64 || msg->envc > 16) {
+		helper_send(fd, SPAWN_FAILED, len >= sizeof(*msg) ? msg->token : 0, 0, EINVAL);
+		return;
+	}
+
+	p = buf + sizeof(*msg);
+	for (i = 0; i < msg->argc + msg->envc; i++) {
+		char *nul = memchr(p, '\0', (size_t)(end - p));
+
+		if (!nul) {
+			helper_send(fd, SPAWN_FAILED, msg->token, 0, EINVAL);
+			return;
+		}
+		if (i < msg->argc)
+			argv[i] = p;
+		else
+			extra[i - msg->argc] = p;
+		p = nul + 1;
+	}
+	argv[msg->argc] = NULL;
+
+	env = helper_environ(extra, msg->envc);
+	if (!env) {
+		helper_send(fd, SPAWN_FAILED, msg->token, 0, ENOMEM);
+		return;
+	}
+
+	sigemptyset(&none);
+	sigemptyset(&defaults);
+	sigaddset(&defaults, SIGCHLD);
+	sigaddset(&defaults, SIGPIPE);
+	sigaddset(&defaults, SIGINT);
+	sigaddset(&defaults, SIGTERM);
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setsigmask(&attr, &none);
+	posix_spawnattr_setsigdefault(&attr, &defaults);
+	posix_spawnattr_setpgroup(&attr, 0);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+	err = posix_spawnp(&pid, argv[0], NULL, &attr, argv, env);
+	posix_spawnattr_destroy(&attr);
+	free(env);
+
+	if (err) {
+		helper_send(fd, SPAWN_FAILED, msg->token, 0, err);
+		return;
+	}
+
+	if (nchildren == children_cap) {
+		struct child *c;
+
+		children_cap = children_cap ? children_cap * 2 : 16;
+		c = realloc(children, children_cap * sizeof(*c));
+		if (c)
+			children = c;
+		else
+			children_cap = nchildren;
+	}
+	if (nchildren < children_cap) {
+		children[nchildren].pid = pid;
+		children[nchildren].token = msg->token;
+		nchildren++;
+	}
+	helper_send(fd, SPAWN_STARTED, msg->token, pid, 0);
+}
+
+static pid_t
+helper_parent_of(pid_t pid)
+{
+	char path[64];
+	FILE *f;
+	pid_t parent_pid = 0;
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+	f = fopen(path, "r");
+	if (!f)
+		return 0;
+
+	/* its like: pid (comm) state ppid ... */
+	if (fscanf(f, "%*d %*s %*c %d", &parent_pid) != 1)
+		parent_pid = 0;
+	fclose(f);
+	return parent_pid;
+}
+
+static void
+helper_parents(int fd, pid_t pid)
+{
+	pid_t current = pid, parent;
+	int depth;
+
+	for (depth = 0; depth < SPAWN_PARENTS_MAX && current > 1; depth++) {
+		parent = helper_parent_of(current);
+		helper_send(fd, SPAWN_PARENT, (uint32_t)pid, current, parent);
+		current = parent;
+	}
+	helper_send(fd, SPAWN_PARENTS_DONE, (uint32_t)pid, pid, 0);
+}
+
+/* the token a process inherited from the spawn that started it, 0 if none */
+static void
+helper_token(int fd, pid_t pid)
+{
+	char path[64], *var = NULL;
+	size_t cap = 0;
+	uint32_t token = 0;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/proc/%d/environ", (int)pid);
+	f = fopen(path, "r");
+	if (f) {
+		while (getdelim(&var, &cap, '\0', f) > 0) {
+			if (strncmp(var, "MURA_SPAWN_TOKEN=", 17) == 0) {
+				token = (uint32_t)strtoul(var + 17, NULL, 10);
+				break;
+			}
+		}
+		free(var);
+		fclose(f);
+	}
+	helper_send(fd, SPAWN_TOKEN, token, pid, 0);
+}
+
+static void
+helper_request(int fd, char *buf, size_t len)
+{
+	struct spawn_msg *msg = (struct spawn_msg *)buf;
+
+	if (len >= sizeof(*msg) && msg->type == MSG_PARENTS)
+		helper_parents(fd, (pid_t)msg->token);
+	else if (len >= sizeof(*msg) && msg->type == MSG_TOKEN)
+		helper_token(fd, (pid_t)msg->token);
+	else
+		helper_spawn(fd, buf, len);
+}
+
+static void __attribute__((noreturn))
+helper_main(int fd)
+{
+	struct sigaction sa;
+	struct pollfd fds[2];
+	char buf[SPAWN_MSG_MAX];
+	ssize_t len;
+
+	signal(SIGINT, SIG_IGN);
+	signal(SIGPIPE, SIG_IGN);
+
+	if (pipe(sigchld_pipe) < 0)
+		_exit(1);
+	fcntl(sigchld_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(sigchld_pipe[1], F_SETFL, O_NONBLOCK);
+	fcntl(sigchld_pipe[0], F_SETFD, FD_CLOEXEC);
+	fcntl(sigchld_pipe[1], F_SETFD, FD_CLOEXEC);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = helper_sigchld;
+	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGCHLD, &sa, NULL);
+
+	fds[0].fd = fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = sigchld_pipe[0];
+	fds[1].events = POLLIN;
+
+	for (;;) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			_exit(1);
+		}
+
+		if (fds[1].revents & POLLIN) {
+			while (read(sigchld_pipe[0], buf, sizeof(buf)) > 0)
+				;
+			helper_reap(fd);
+		}
+
+		if (fds[0].revents & (POLLIN | POLLHUP)) {
+			len = recv(fd, buf, sizeof(buf), 0);
+			/* mura went away */
+			if (len == 0 || (len < 0 && errno != EINTR && errno != EAGAIN))
+				_exit(0);
+			if (len > 0)
+				helper_request(fd, buf, (size_t)len);
+		}
+	}
+}
+
+int
+spawn_helper_start(void)
+{
+	int sv[2];
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+		return -1;
+
+	pid = fork();
+	if (pid < 0) {
+		close(sv[0]);
+		close(sv[1]);
+		return -1;
+	}
+	if (pid == 0) {
+		close(sv[0]);
+		fcntl(sv[1], F_SETFD, FD_CLOEXEC);
+		helper_main(sv[1]);
+	}
+
+	close(sv[1]);
+	fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+	fcntl(sv[0], F_SETFL, O_NONBLOCK);
+	return sv[0];
+}
+
+/* requests the socket had no room for, each a size_t length followed by
+ * the message, oldest first */
+static char *queue;
+static size_t queue_len, queue_cap;
+
+#define QUEUE_MAX (256 * 1024)
+
+static bool
+queue_add(const char *buf, size_t len)
+{
+	size_t need = queue_len + sizeof(len) + len;
+
+	if (need > QUEUE_MAX) {
+		errno = ENOBUFS;
+		return false;
+	}
+	if (need > queue_cap) {
+		size_t cap = queue_cap ? queue_cap : SPAWN_MSG_MAX;
+		char *q;
+
+		while (cap < need)
+			cap *= 2;
+		q = realloc(queue, cap);
+		if (!q)
+			return false;
+		queue = q;
+		queue_cap = cap;
+	}
+	memcpy(queue + queue_len, &len, sizeof(len));
+	memcpy(queue + queue_len + sizeof(len), buf, len);
+	queue_len = need;
+	return true;
+}
+
+bool
+spawn_flush(int fd)
+{
+	size_t off = 0, len;
+	bool ok = true;
+
+	while (off < queue_len) {
+		memcpy(&len, queue + off, sizeof(len));
+		if (send(fd, queue + off + sizeof(len), len, MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t)len) {
+			if (errno == EINTR)
+				continue;
+			ok = errno == EAGAIN || errno == EWOULDBLOCK;
+			break;
+		}
+		off += sizeof(len) + len;
+	}
+	memmove(queue, queue + off, queue_len - off);
+	queue_len -= off;
+	return ok;
+}
+
+bool
+spawn_pending(void)
+{
+	return queue_len > 0;
+}
+
+/* a full socket is only the helper being busy, the message waits its turn */
+static bool
+spawn_send(int fd, const char *buf, size_t len)
+{
+	ssize_t n;
+
+	if (!queue_len) {
+		do
+			n = send(fd, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+		while (n < 0 && errno == EINTR);
+		if (n == (ssize_t)len)
+			return true;
+		if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+			return false;
+	}
+	return queue_add(buf, len);
+}
+
+bool
+spawn_request(int fd, uint32_t token, char *const argv[], char *const env[])
+{
+	char buf[SPAWN_MSG_MAX];
+	struct spawn_msg msg = { MSG_SPAWN, 0, 0, token };
+	size_t len = sizeof(msg), n;
+
+	for (; argv && argv[msg.argc]; msg.argc++) {
+		n = strlen(argv[msg.argc]) + 1;
+		if (len + n > sizeof(buf)) {
+			errno = E2BIG;
+			return false;
+		}
+		memcpy(buf + len, argv[msg.argc], n);
+		len += n;
+	}
+	for (; env && env[msg.envc]; msg.envc++) {
+		n = strlen(env[msg.envc]) + 1;
+		if (len + n > sizeof(buf)) {
+			errno = E2BIG;
+			return false;
+		}
+		memcpy(buf + len, env[msg.envc], n);
+		len += n;
+	}
+	memcpy(buf, &msg, sizeof(msg));
+
+	return spawn_send(fd, buf, len);
+}
+
+bool
+spawn_request_parents(int fd, pid_t pid)
+{
+	struct spawn_msg msg = { MSG_PARENTS, 0, 0, (uint32_t)pid };
+
+	return spawn_send(fd, (const char *)&msg, sizeof(msg));
+}
+
+bool
+spawn_request_token(int fd, pid_t pid)
+{
+	struct spawn_msg msg = { MSG_TOKEN, 0, 0, (uint32_t)pid };
+
+	return spawn_send(fd, (const char *)&msg, sizeof(msg));
+}
+
+bool
+spawn_read_event(int fd, struct spawn_event *ev)
+{
+	return recv(fd, ev, sizeof(*ev), 0) == (ssize_t)sizeof(*ev);
+}
@@ -0,0 +1,65 @@
+/* spawner: launch programs from a small helper process that is forked while
+ * mura is still small, so the compositor itself never has to fork. the
+ * helper also reads /proc for mura, so that never blocks the compositor.
+ *
+ * mura and the helper talk over a SOCK_SEQPACKET socketpair: every request
+ * and every event is exactly one message.
+ */
+#ifndef SPAWNER_H
+#define SPAWNER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define SPAWN_MSG_MAX 4096
+
+enum spawn_event_type {
+	SPAWN_STARTED = 1,  /* pid is valid */
+	SPAWN_FAILED,       /* status holds the errno of posix_spawn */
+	SPAWN_EXITED,       /* status is what waitpid() reported */
+	SPAWN_PARENT,       /* token is the queried pid, status is the ppid of pid */
+	SPAWN_PARENTS_DONE, /* token is the queried pid, no more SPAWN_PARENT for it */
+	SPAWN_TOKEN,        /* pid is the queried pid, token the one in its environment or 0 */
+};
+
+/* how many ancestors spawn_request_parents() reports */
+#define SPAWN_PARENTS_MAX 10
+
+struct spawn_event {
+	uint32_t type;
+	uint32_t token;
+	int32_t pid;
+	int32_t status;
+};
+
+/* fork the helper, returns mura's end of the socket or -1 */
+int spawn_helper_start(void);
+
+/* ask the helper to run argv with env ("KEY=value", NULL terminated, may be
+ * NULL) added to its environment. token comes back in every event about this
+ * child. never blocks: when the socket is full the request is queued for
+ * spawn_flush(). false with errno E2BIG if it does not fit in a message,
+ * anything else means the helper is gone. */
+bool spawn_request(int fd, uint32_t token, char *const argv[], char *const env[]);
+
+/* ask the helper for the ancestors of pid, answered by a SPAWN_PARENT event
+ * per ancestor from pid upwards, stopping before init, then SPAWN_PARENTS_DONE.
+ * queued like spawn_request() */
+bool spawn_request_parents(int fd, pid_t pid);
+
+/* ask the helper which spawn pid was started by, answered by SPAWN_TOKEN
+ * with the MURA_SPAWN_TOKEN pid inherited. queued like spawn_request() */
+bool spawn_request_token(int fd, pid_t pid);
+
+/* whether queued requests wait for room on the socket */
+bool spawn_pending(void);
+
+/* send what the socket has room for, false if the helper is gone. requests
+ * still queued then go to the next helper */
+bool spawn_flush(int fd);
+
+/* read one pending event, false when there is none */
+bool spawn_read_event(int fd, struct spawn_event *ev);
+
+#endif
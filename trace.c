@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "trace.h"
+
+struct trace_header *trace_ring;
+
+static struct trace_record *records;
+static size_t mapped;
+
+/* strings are almost always literals, so the pointer is checked first */
+static const char *interned[TRACE_STRINGS];
+
+bool
+trace_open(const char *path, uint32_t capacity)
+{
+	uint32_t cap = 1;
+	void *map;
+	int fd;
+
+	while (cap < capacity && cap < (1u << 30))
+		cap <<= 1;
+	mapped = sizeof(struct trace_header) + (size_t)cap * sizeof(struct trace_record);
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+	if (ftruncate(fd, (off_t)mapped) < 0) {
+		close(fd);
+		return false;
+	}
+	map = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	trace_ring = map;
+	records = (struct trace_record *)(trace_ring + 1);
+	trace_ring->version = TRACE_VERSION;
+	trace_ring->capacity = cap;
+	trace_ring->record_size = sizeof(struct trace_record);
+	trace_ring->head = 0;
+	trace_ring->nstrings = 0;
+	memset(interned, 0, sizeof(interned));
+	trace_string("?");
+
+	/* readers check the magic last */
+	__atomic_store_n(&trace_ring->magic, TRACE_MAGIC, __ATOMIC_RELEASE);
+	return true;
+}
+
+void
+trace_close(void)
+{
+	if (!trace_ring)
+		return;
+	munmap(trace_ring, mapped);
+	trace_ring = NULL;
+	records = NULL;
+}
+
+uint16_t
+trace_string(const char *s)
+{
+	uint32_t i, n = trace_ring->nstrings;
+
+	for (i = 0; i < n; i++) {
+		if (interned[i] == s)
+			return (uint16_t)i;
+	}
+	for (i = 0; i < n; i++) {
+		if (strncmp(trace_ring->strings[i], s, TRACE_STRING_LEN - 1) == 0)
+			return (uint16_t)i;
+	}
+	if (n == TRACE_STRINGS)
+		return 0;
+
+	snprintf(trace_ring->strings[n], TRACE_STRING_LEN, "%s", s);
+	interned[n] = s;
+	__atomic_store_n(&trace_ring->nstrings, n + 1, __ATOMIC_RELEASE);
+	return (uint16_t)n;
+}
+
+void
+trace_write(uint16_t type, uint16_t name, uint64_t ts, uint32_t dur, int32_t a, int32_t b)
+{
+	uint64_t head = trace_ring->head;
+	struct trace_record *r = &records[head & (trace_ring->capacity - 1)];
+
+	r->ts = ts;
+	r->dur = dur;
+	r->type = type;
+	r->name = name;
+	r->a = a;
+	r->b = b;
+	__atomic_store_n(&trace_ring->head, head + 1, __ATOMIC_RELEASE);
+}
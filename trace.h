@@ -0,0 +1,67 @@
+/* trace: a fixed-size ring of binary event records in a shared file, written
+ * by mura and read by extra/mura-trace while it runs or after it is gone.
+ *
+ * mura is the only writer. it fills the slot at head and then publishes
+ * head + 1, a reader copies what it wants and checks head again to drop any
+ * record that was overwritten under it. nothing is formatted on mura's side,
+ * names are interned once into the header's string table.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACE_MAGIC 0x5452554d /* "MURT" */
+#define TRACE_VERSION 1
+#define TRACE_STRINGS 128
+#define TRACE_STRING_LEN 32
+
+enum trace_type {
+	TRACE_SPAN = 1, /* name ran for dur ns from ts */
+	TRACE_MARK,     /* name happened */
+	TRACE_FOCUS,    /* name is the reason, a and b the windows */
+	TRACE_BUTTON,   /* a is the button, b is 1 when pressed */
+	TRACE_WINDOW,   /* a is the window, b its pid */
+	TRACE_SCREEN,   /* a and b are the size */
+	TRACE_SPAWN,    /* a and b are the selected size */
+	TRACE_SCROLL,   /* a is what is left to scroll, b the step taken */
+	TRACE_SLOW,     /* name ran dur ns, past slow_handler_ms, a is the client pid or 0 */
+};
+
+struct trace_record {
+	uint64_t ts; /* CLOCK_MONOTONIC ns */
+	uint32_t dur;
+	uint16_t type;
+	uint16_t name;
+	int32_t a, b;
+};
+
+/* followed by capacity records, capacity is a power of two */
+struct trace_header {
+	uint32_t magic, version;
+	uint32_t capacity, record_size;
+	uint64_t head; /* records written so far */
+	uint32_t nstrings;
+	char strings[TRACE_STRINGS][TRACE_STRING_LEN];
+};
+
+extern struct trace_header *trace_ring;
+
+/* map a ring of at least capacity records at path */
+bool trace_open(const char *path, uint32_t capacity);
+void trace_close(void);
+
+/* index of s in the string table, 0 ("?") once it is full */
+uint16_t trace_string(const char *s);
+
+void trace_write(uint16_t type, uint16_t name, uint64_t ts, uint32_t dur, int32_t a, int32_t b);
+
+/* costs one branch while tracing is off, arguments are not evaluated */
+#define TRACE(type, name, ts, dur, a, b) \
+	do { \
+		if (trace_ring) \
+			trace_write(type, name, ts, dur, a, b); \
+	} while (0)
+
+#endif